@@ -0,0 +1,204 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "async-log.h"
+
+#include "plugin-support.h"
+
+#include <util/base.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include <atomic>
+#include <thread>
+
+// Must be a power of two
+#define ASYNC_LOG_SLOTS 256
+// Longer messages are truncated
+#define ASYNC_LOG_MESSAGE_SIZE 512
+
+/**
+ * Bounded multi-producer queue: a producer claims a slot by advancing
+ * `enqueue_pos`, and `sequence` tells whose turn it is for that slot:
+ * pos when it is free for the producer of pos, pos + 1 once that message is
+ * readable, and pos + ASYNC_LOG_SLOTS once the logger thread has consumed it.
+ *
+ * A queue shared by all threads rather than one per thread, because the OBS
+ * audio and graphics threads outlive the module and must not be left holding
+ * per-thread state that would need cleaning up.
+ */
+typedef struct async_log_slot_t {
+	std::atomic<size_t> sequence;
+	int log_level;
+	char message[ASYNC_LOG_MESSAGE_SIZE];
+} async_log_slot_t;
+
+static async_log_slot_t slots[ASYNC_LOG_SLOTS];
+static std::atomic<size_t> enqueue_pos;
+static size_t dequeue_pos;
+static std::atomic<long> dropped;
+static long dropped_total;
+
+// Writers inside async_log_write; deinit waits for them before the last drain
+static std::atomic<long> writers;
+static std::atomic<bool> accepting;
+
+static os_sem_t *wake = nullptr;
+static std::thread logger;
+static std::atomic<bool> logger_running;
+
+static void async_log_enqueue(int log_level, const char *format,
+			      va_list args)
+{
+	async_log_slot_t *slot;
+	size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+	for (;;) {
+		slot = &slots[pos & (ASYNC_LOG_SLOTS - 1)];
+		size_t sequence =
+			slot->sequence.load(std::memory_order_acquire);
+		auto diff = (intptr_t)(sequence - pos);
+		if (diff == 0) {
+			if (enqueue_pos.compare_exchange_weak(
+				    pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// Full: the logger thread has not caught up
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			pos = enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->log_level = log_level;
+	int length = vsnprintf(slot->message, ASYNC_LOG_MESSAGE_SIZE, format,
+			       args);
+	if (length >= ASYNC_LOG_MESSAGE_SIZE) {
+		memcpy(slot->message + ASYNC_LOG_MESSAGE_SIZE - 4, "...", 4);
+	}
+	slot->sequence.store(pos + 1, std::memory_order_release);
+
+	os_sem_post(wake);
+}
+
+static void async_log_write(int log_level, const char *format, va_list args)
+{
+	writers.fetch_add(1);
+	if (accepting.load()) {
+		async_log_enqueue(log_level, format, args);
+	} else {
+		// Picked up the handler just before deinit reset it
+		char message[ASYNC_LOG_MESSAGE_SIZE];
+		vsnprintf(message, sizeof(message), format, args);
+		blog(log_level, "[%s] %s", PLUGIN_DISPLAY_NAME, message);
+	}
+	writers.fetch_sub(1, std::memory_order_release);
+}
+
+/**
+ * Forwards every readable message to `blog`.
+ * Only called from the logger thread, or after it has stopped.
+ */
+static void async_log_drain()
+{
+	for (;;) {
+		auto slot = &slots[dequeue_pos & (ASYNC_LOG_SLOTS - 1)];
+		if (slot->sequence.load(std::memory_order_acquire) !=
+		    dequeue_pos + 1) {
+			break;
+		}
+		blog(slot->log_level, "[%s] %s", PLUGIN_DISPLAY_NAME,
+		     slot->message);
+		slot->sequence.store(dequeue_pos + ASYNC_LOG_SLOTS,
+				     std::memory_order_release);
+		++dequeue_pos;
+	}
+
+	long count = dropped.exchange(0, std::memory_order_relaxed);
+	dropped_total += count;
+	if (count) {
+		blog(LOG_WARNING,
+		     "[%s] async_log: %ld messages dropped, the log queue was full",
+		     PLUGIN_DISPLAY_NAME, count);
+	}
+}
+
+static void async_log_thread()
+{
+	os_set_thread_name("distroav: logger");
+	while (logger_running.load(std::memory_order_acquire)) {
+		os_sem_wait(wake);
+		async_log_drain();
+	}
+}
+
+void async_log_init()
+{
+	if (logger_running) {
+		return;
+	}
+
+	for (size_t i = 0; i < ASYNC_LOG_SLOTS; ++i) {
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	enqueue_pos = 0;
+	dequeue_pos = 0;
+	dropped = 0;
+	dropped_total = 0;
+
+	if (!wake && os_sem_init(&wake, 0) != 0) {
+		obs_log(LOG_ERROR,
+			"async_log_init: cannot create semaphore, logging stays synchronous");
+		return;
+	}
+	logger_running = true;
+	logger = std::thread(async_log_thread);
+	accepting = true;
+	obs_log_set_handler(async_log_write);
+}
+
+void async_log_deinit()
+{
+	if (!logger_running) {
+		return;
+	}
+
+	// Messages from now on are written synchronously again. A writer that
+	// already holds the handler either is counted in `writers` or sees
+	// `accepting` cleared and writes synchronously itself. Both sides store
+	// then load, so both need seq_cst for one to see the other's store.
+	obs_log_set_handler(nullptr);
+	accepting = false;
+	while (writers.load() != 0) {
+		std::this_thread::yield();
+	}
+
+	logger_running = false;
+	os_sem_post(wake);
+	logger.join();
+	async_log_drain();
+
+	if (dropped_total) {
+		blog(LOG_WARNING,
+		     "[%s] async_log_deinit: %ld messages dropped in total",
+		     PLUGIN_DISPLAY_NAME, dropped_total);
+	}
+
+	os_sem_destroy(wake);
+	wake = nullptr;
+}
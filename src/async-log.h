@@ -0,0 +1,30 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/**
+ * Moves `obs_log` I/O off the calling thread.
+ *
+ * Between init and deinit, `obs_log` only formats the message into a bounded
+ * lock-free queue; a logger thread forwards the queue to `blog`. When the
+ * queue is full the message is dropped and counted rather than waited for.
+ * Deinit restores synchronous logging, waits for writers still in the queue,
+ * then writes out what is left and the number of dropped messages.
+ */
+void async_log_init();
+void async_log_deinit();
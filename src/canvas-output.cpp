@@ -0,0 +1,269 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "canvas-output.h"
+
+#include "plugin-main.h"
+
+#include <vector>
+
+struct canvas_output {
+	bool is_running;
+	QString ndi_name;
+	QString ndi_groups;
+	// Not the name, so renaming the scene keeps it bound
+	QString scene_uuid;
+	int width;
+	int height;
+
+	obs_output_t *output;
+
+	// Renders the scene into its own mix; OBS does the GPU conversion
+	obs_view_t *view;
+	video_t *video;
+};
+
+// In the order of Config::CanvasOutputs
+static std::vector<canvas_output *> contexts;
+
+static void canvas_output_view_destroy(canvas_output *context)
+{
+	if (context->view) {
+		if (context->video) {
+			obs_view_remove(context->view);
+			context->video = nullptr;
+		}
+		obs_view_set_source(context->view, 0, nullptr);
+		obs_view_destroy(context->view);
+		context->view = nullptr;
+	}
+}
+
+static void canvas_output_stop(canvas_output *context)
+{
+	obs_log(LOG_INFO, "+canvas_output_stop()");
+	if (context->is_running) {
+		obs_log(LOG_INFO,
+			"canvas_output_stop: stopping NDI canvas output '%s'",
+			context->ndi_name.toUtf8().constData());
+		obs_output_stop(context->output);
+		canvas_output_view_destroy(context);
+		context->is_running = false;
+		obs_log(LOG_INFO,
+			"canvas_output_stop: successfully stopped NDI canvas output '%s'",
+			context->ndi_name.toUtf8().constData());
+	} else {
+		obs_log(LOG_ERROR,
+			"canvas_output_stop: NDI canvas output `%s` is not running",
+			context->ndi_name.toUtf8().constData());
+	}
+	obs_log(LOG_INFO, "-canvas_output_stop()");
+}
+
+static void canvas_output_start(canvas_output *context)
+{
+	obs_log(LOG_INFO, "+canvas_output_start()");
+	auto output_name_utf8 = context->ndi_name.toUtf8();
+	auto output_name = output_name_utf8.constData();
+	if (context->output) {
+		if (context->is_running) {
+			canvas_output_stop(context);
+		}
+
+		auto scene_uuid = context->scene_uuid.toUtf8();
+		obs_source_t *scene = obs_get_source_by_uuid(scene_uuid);
+		if (!scene) {
+			obs_log(LOG_ERROR,
+				"canvas_output_start: scene '%s' not found for NDI canvas output '%s'",
+				scene_uuid.constData(), output_name);
+			obs_log(LOG_INFO, "-canvas_output_start()");
+			return;
+		}
+
+		obs_log(LOG_INFO,
+			"canvas_output_start: starting NDI canvas output '%s' with scene '%s' at %dx%d",
+			output_name, obs_source_get_name(scene), context->width,
+			context->height);
+
+		// Same settings as the main mix except for the resolution
+		obs_video_info ovi;
+		obs_get_video_info(&ovi);
+		ovi.base_width = (uint32_t)context->width;
+		ovi.base_height = (uint32_t)context->height;
+		ovi.output_width = (uint32_t)context->width;
+		ovi.output_height = (uint32_t)context->height;
+
+		context->view = obs_view_create();
+		obs_view_set_source(context->view, 0, scene);
+		obs_source_release(scene);
+		context->video = obs_view_add2(context->view, &ovi);
+		if (!context->video) {
+			obs_log(LOG_ERROR,
+				"canvas_output_start: failed to create video mix for NDI canvas output '%s'",
+				output_name);
+			canvas_output_view_destroy(context);
+			obs_log(LOG_INFO, "-canvas_output_start()");
+			return;
+		}
+
+		obs_output_set_media(context->output, context->video,
+				     obs_get_audio());
+		context->is_running = obs_output_start(context->output);
+		if (context->is_running) {
+			obs_log(LOG_INFO,
+				"canvas_output_start: successfully started NDI canvas output '%s'",
+				output_name);
+		} else {
+			auto error = obs_output_get_last_error(context->output);
+			obs_log(LOG_ERROR,
+				"canvas_output_start: failed to start NDI canvas output '%s'; error='%s'",
+				output_name, error);
+			canvas_output_view_destroy(context);
+		}
+	} else {
+		obs_log(LOG_ERROR,
+			"canvas_output_start: NDI canvas output '%s' is not initialized",
+			output_name);
+	}
+	obs_log(LOG_INFO, "-canvas_output_start()");
+}
+
+static void canvas_output_release(canvas_output *context)
+{
+	if (context->output) {
+		if (context->is_running) {
+			canvas_output_stop(context);
+		}
+
+		auto output_name_utf8 = context->ndi_name.toUtf8();
+		auto output_name = output_name_utf8.constData();
+		obs_log(LOG_INFO,
+			"canvas_output_release: releasing NDI canvas output '%s'",
+			output_name);
+
+		obs_output_release(context->output);
+		context->output = nullptr;
+		obs_log(LOG_INFO,
+			"canvas_output_release: successfully released NDI canvas output '%s'",
+			output_name);
+	}
+	delete context;
+}
+
+/**
+ * @return a canvas output for `config`, not started; its `output` is
+ * nullptr if it could not be created
+ */
+static canvas_output *canvas_output_create(const CanvasOutputConfig &config,
+					   const QString &scene_uuid)
+{
+	auto context = new canvas_output();
+	context->ndi_name = config.Name;
+	context->ndi_groups = config.Groups;
+	context->scene_uuid = scene_uuid;
+	context->width = config.Width;
+	context->height = config.Height;
+	if (config.Name.isEmpty()) {
+		return context;
+	}
+
+	auto output_name_utf8 = config.Name.toUtf8();
+	auto output_name = output_name_utf8.constData();
+	obs_log(LOG_INFO, "canvas_output_create: creating NDI canvas output '%s'",
+		output_name);
+	obs_data_t *output_settings = obs_data_create();
+	obs_data_set_string(output_settings, "ndi_name", output_name);
+	obs_data_set_string(output_settings, "ndi_groups",
+			    QT_TO_UTF8(config.Groups));
+	context->output = obs_output_create("ndi_output", "NDI Canvas Output",
+					    output_settings, nullptr);
+	obs_data_release(output_settings);
+	if (context->output) {
+		obs_log(LOG_INFO,
+			"canvas_output_create: successfully created NDI canvas output '%s'",
+			output_name);
+	} else {
+		obs_log(LOG_ERROR,
+			"canvas_output_create: failed to create NDI canvas output '%s'",
+			output_name);
+	}
+	return context;
+}
+
+void canvas_output_deinit()
+{
+	obs_log(LOG_INFO, "+canvas_output_deinit()");
+	for (auto context : contexts) {
+		canvas_output_release(context);
+	}
+	contexts.clear();
+	obs_log(LOG_INFO, "-canvas_output_deinit()");
+}
+
+void canvas_output_init()
+{
+	obs_log(LOG_INFO, "+canvas_output_init()");
+
+	auto config = Config::Current();
+	const auto &configs = config->CanvasOutputs;
+
+	// Outputs past the end of the list were removed
+	while (contexts.size() > (size_t)configs.size()) {
+		canvas_output_release(contexts.back());
+		contexts.pop_back();
+	}
+
+	for (qsizetype i = 0; i < configs.size(); i++) {
+		const auto &canvas_config = configs[i];
+		// Resolved here, as the scene collection may have changed
+		auto scene_uuid = canvas_config.SceneUuid();
+
+		// Only re-created when something the NDI sender or the video
+		// mix was created with changed
+		auto context = i < (qsizetype)contexts.size() ? contexts[i]
+							       : nullptr;
+		if (!context || !context->output ||
+		    canvas_config.Name != context->ndi_name ||
+		    canvas_config.Groups != context->ndi_groups ||
+		    scene_uuid != context->scene_uuid ||
+		    canvas_config.Width != context->width ||
+		    canvas_config.Height != context->height) {
+			// Released first, so that the NDI name is free again
+			if (context) {
+				canvas_output_release(context);
+			}
+			context = canvas_output_create(canvas_config,
+						       scene_uuid);
+			if (i < (qsizetype)contexts.size()) {
+				contexts[i] = context;
+			} else {
+				contexts.push_back(context);
+			}
+		}
+
+		bool is_enabled = canvas_config.Enabled && context->output;
+		if (context->is_running != is_enabled) {
+			if (is_enabled) {
+				canvas_output_start(context);
+			} else {
+				canvas_output_stop(context);
+			}
+		}
+	}
+
+	obs_log(LOG_INFO, "-canvas_output_init()");
+}
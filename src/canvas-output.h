@@ -0,0 +1,26 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+/**
+ * NDI outputs of single scenes, each rendered into its own OBS video mix at
+ * its own resolution (ex: a vertical program next to the main landscape one).
+ * The list is configured in the output settings (Config::CanvasOutputs).
+ */
+void canvas_output_deinit();
+void canvas_output_init();
@@ -22,14 +22,20 @@
 #include <util/config-file.h>
 
 #include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 #define SECTION_NAME "NDIPlugin"
 #define PARAM_MAIN_OUTPUT_ENABLED "MainOutputEnabled"
 #define PARAM_MAIN_OUTPUT_NAME "MainOutputName"
 #define PARAM_MAIN_OUTPUT_GROUPS "MainOutputGroups"
+#define PARAM_MAIN_OUTPUT_UYVA "MainOutputUYVA"
 #define PARAM_PREVIEW_OUTPUT_ENABLED "PreviewOutputEnabled"
 #define PARAM_PREVIEW_OUTPUT_NAME "PreviewOutputName"
 #define PARAM_PREVIEW_OUTPUT_GROUPS "PreviewOutputGroups"
+#define PARAM_PREVIEW_OUTPUT_UYVA "PreviewOutputUYVA"
+#define PARAM_CANVAS_OUTPUTS "CanvasOutputs"
 #define PARAM_TALLY_PROGRAM_ENABLED "TallyProgramEnabled"
 #define PARAM_TALLY_PREVIEW_ENABLED "TallyPreviewEnabled"
 #define PARAM_AUTO_CHECK_FOR_UPDATES "AutoCheckForUpdates"
@@ -37,6 +43,11 @@
 #define PARAM_LAST_UPDATE_CHECK "LastUpdateCheck"
 #define PARAM_MIN_AUTO_UPDATE_CHECK_INTERVAL_SECONDS \
 	"MinAutoUpdateCheckIntervalSeconds"
+#define PARAM_PROBE_OBSNDI_DIRS "ProbeObsNdiDirs"
+#define PARAM_PROBE_OBSNDI_FOUND "ProbeObsNdiFound"
+#define PARAM_PROBE_NDILIB_DIRS "ProbeNdiLibDirs"
+#define PARAM_PROBE_NDILIB_PATH "ProbeNdiLibPath"
+#define PARAM_PROBE_NDILIB_VERSION "ProbeNdiLibVersion"
 
 Config *Config::_instance = nullptr;
 
@@ -44,6 +55,7 @@ int Config::UpdateForce = 0;
 int Config::UpdateLocalPort = 0;
 bool Config::UpdateLastCheckIgnore = false;
 int Config::DetectObsNdiForce = 0;
+bool Config::ProbeCacheIgnore = false;
 
 void ProcessCommandLine()
 {
@@ -150,17 +162,100 @@ void ProcessCommandLine()
 					Config::DetectObsNdiForce = 1;
 				}
 			}
+			continue;
+		}
+
+		//
+		// Startup probes
+		//
+		if (argument == "--distroav-probe-cache-ignore") {
+			obs_log(LOG_INFO,
+				"config: DistroAV probe cache ignore enabled");
+			Config::ProbeCacheIgnore = true;
+			continue;
+		}
+	}
+}
+
+static QString CurrentSceneCollection()
+{
+	auto collection = obs_frontend_get_current_scene_collection();
+	QString name = collection ? collection : "";
+	bfree(collection);
+	return name;
+}
+
+QString CanvasOutputConfig::SceneUuid() const
+{
+	return SceneUuids.value(CurrentSceneCollection());
+}
+
+void CanvasOutputConfig::SceneUuid(const QString &uuid)
+{
+	auto collection = CurrentSceneCollection();
+	if (uuid.isEmpty()) {
+		SceneUuids.remove(collection);
+	} else {
+		SceneUuids.insert(collection, uuid);
+	}
+}
+
+static QList<CanvasOutputConfig> CanvasOutputsFromJson(const char *json)
+{
+	QList<CanvasOutputConfig> canvasOutputs;
+	auto array = QJsonDocument::fromJson(json ? json : "").array();
+	for (const auto &value : array) {
+		auto object = value.toObject();
+		CanvasOutputConfig canvasOutput;
+		canvasOutput.Enabled = object["enabled"].toBool();
+		canvasOutput.Name = object["name"].toString();
+		canvasOutput.Groups = object["groups"].toString();
+		auto scenes = object["scenes"].toObject();
+		for (auto it = scenes.begin(); it != scenes.end(); ++it) {
+			canvasOutput.SceneUuids.insert(it.key(),
+						       it.value().toString());
+		}
+		canvasOutput.Width = object["width"].toInt(canvasOutput.Width);
+		canvasOutput.Height =
+			object["height"].toInt(canvasOutput.Height);
+		canvasOutputs.append(canvasOutput);
+	}
+	return canvasOutputs;
+}
+
+static QString
+CanvasOutputsToJson(const QList<CanvasOutputConfig> &canvasOutputs)
+{
+	QJsonArray array;
+	for (const auto &canvasOutput : canvasOutputs) {
+		QJsonObject scenes;
+		for (auto it = canvasOutput.SceneUuids.begin();
+		     it != canvasOutput.SceneUuids.end(); ++it) {
+			scenes[it.key()] = it.value();
 		}
+		QJsonObject object;
+		object["enabled"] = canvasOutput.Enabled;
+		object["name"] = canvasOutput.Name;
+		object["groups"] = canvasOutput.Groups;
+		object["scenes"] = scenes;
+		object["width"] = canvasOutput.Width;
+		object["height"] = canvasOutput.Height;
+		array.append(object);
 	}
+	return QString::fromUtf8(
+		QJsonDocument(array).toJson(QJsonDocument::Compact));
 }
 
 Config::Config()
 	: OutputEnabled(false),
 	  OutputName("OBS"),
 	  OutputGroups(""),
+	  OutputUYVA(false),
 	  PreviewOutputEnabled(false),
 	  PreviewOutputName("OBS Preview"),
 	  PreviewOutputGroups(""),
+	  PreviewOutputUYVA(false),
+	  CanvasOutputs(),
 	  TallyProgramEnabled(true),
 	  TallyPreviewEnabled(true)
 {
@@ -181,6 +276,8 @@ void Config::SetDefaultsToGlobalStore()
 		config_set_default_string(obs_config, SECTION_NAME,
 					  PARAM_MAIN_OUTPUT_GROUPS,
 					  QT_TO_UTF8(OutputGroups));
+		config_set_default_bool(obs_config, SECTION_NAME,
+					PARAM_MAIN_OUTPUT_UYVA, OutputUYVA);
 
 		config_set_default_bool(obs_config, SECTION_NAME,
 					PARAM_PREVIEW_OUTPUT_ENABLED,
@@ -191,6 +288,12 @@ void Config::SetDefaultsToGlobalStore()
 		config_set_default_string(obs_config, SECTION_NAME,
 					  PARAM_PREVIEW_OUTPUT_GROUPS,
 					  QT_TO_UTF8(PreviewOutputGroups));
+		config_set_default_bool(obs_config, SECTION_NAME,
+					PARAM_PREVIEW_OUTPUT_UYVA,
+					PreviewOutputUYVA);
+
+		config_set_default_string(obs_config, SECTION_NAME,
+					  PARAM_CANVAS_OUTPUTS, "[]");
 
 		config_set_default_bool(obs_config, SECTION_NAME,
 					PARAM_TALLY_PROGRAM_ENABLED,
@@ -214,6 +317,8 @@ void Config::Load()
 					       PARAM_MAIN_OUTPUT_NAME);
 		OutputGroups = config_get_string(obs_config, SECTION_NAME,
 						 PARAM_MAIN_OUTPUT_GROUPS);
+		OutputUYVA = config_get_bool(obs_config, SECTION_NAME,
+					     PARAM_MAIN_OUTPUT_UYVA);
 
 		PreviewOutputEnabled = config_get_bool(
 			obs_config, SECTION_NAME, PARAM_PREVIEW_OUTPUT_ENABLED);
@@ -221,6 +326,11 @@ void Config::Load()
 			obs_config, SECTION_NAME, PARAM_PREVIEW_OUTPUT_NAME);
 		PreviewOutputGroups = config_get_string(
 			obs_config, SECTION_NAME, PARAM_PREVIEW_OUTPUT_GROUPS);
+		PreviewOutputUYVA = config_get_bool(obs_config, SECTION_NAME,
+						    PARAM_PREVIEW_OUTPUT_UYVA);
+
+		CanvasOutputs = CanvasOutputsFromJson(config_get_string(
+			obs_config, SECTION_NAME, PARAM_CANVAS_OUTPUTS));
 
 		TallyProgramEnabled = config_get_bool(
 			obs_config, SECTION_NAME, PARAM_TALLY_PROGRAM_ENABLED);
@@ -241,6 +351,8 @@ void Config::Save()
 		config_set_string(obs_config, SECTION_NAME,
 				  PARAM_MAIN_OUTPUT_GROUPS,
 				  QT_TO_UTF8(OutputGroups));
+		config_set_bool(obs_config, SECTION_NAME,
+				PARAM_MAIN_OUTPUT_UYVA, OutputUYVA);
 
 		config_set_bool(obs_config, SECTION_NAME,
 				PARAM_PREVIEW_OUTPUT_ENABLED,
@@ -251,6 +363,13 @@ void Config::Save()
 		config_set_string(obs_config, SECTION_NAME,
 				  PARAM_PREVIEW_OUTPUT_GROUPS,
 				  QT_TO_UTF8(PreviewOutputGroups));
+		config_set_bool(obs_config, SECTION_NAME,
+				PARAM_PREVIEW_OUTPUT_UYVA, PreviewOutputUYVA);
+
+		auto canvasOutputs = CanvasOutputsToJson(CanvasOutputs);
+		config_set_string(obs_config, SECTION_NAME,
+				  PARAM_CANVAS_OUTPUTS,
+				  QT_TO_UTF8(canvasOutputs));
 
 		config_set_bool(obs_config, SECTION_NAME,
 				PARAM_TALLY_PROGRAM_ENABLED,
@@ -351,6 +470,103 @@ void Config::MinAutoUpdateCheckIntervalSeconds(int seconds)
 	}
 }
 
+QString Config::ProbeObsNdiDirs()
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		auto dirs = config_get_string(obs_config, SECTION_NAME,
+					      PARAM_PROBE_OBSNDI_DIRS);
+		if (dirs) {
+			return QString::fromUtf8(dirs);
+		}
+	}
+	return QString();
+}
+
+bool Config::ProbeObsNdiFound()
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		return config_get_bool(obs_config, SECTION_NAME,
+				       PARAM_PROBE_OBSNDI_FOUND);
+	}
+	return false;
+}
+
+void Config::ProbeObsNdi(const QString &dirs, bool found)
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		config_set_string(obs_config, SECTION_NAME,
+				  PARAM_PROBE_OBSNDI_DIRS, QT_TO_UTF8(dirs));
+		config_set_bool(obs_config, SECTION_NAME,
+				PARAM_PROBE_OBSNDI_FOUND, found);
+		config_save(obs_config);
+	}
+}
+
+QString Config::ProbeNdiLibDirs()
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		auto dirs = config_get_string(obs_config, SECTION_NAME,
+					      PARAM_PROBE_NDILIB_DIRS);
+		if (dirs) {
+			return QString::fromUtf8(dirs);
+		}
+	}
+	return QString();
+}
+
+QString Config::ProbeNdiLibPath()
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		auto path = config_get_string(obs_config, SECTION_NAME,
+					      PARAM_PROBE_NDILIB_PATH);
+		if (path) {
+			return QString::fromUtf8(path);
+		}
+	}
+	return QString();
+}
+
+void Config::ProbeNdiLib(const QString &dirs, const QString &path)
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		config_set_string(obs_config, SECTION_NAME,
+				  PARAM_PROBE_NDILIB_DIRS, QT_TO_UTF8(dirs));
+		config_set_string(obs_config, SECTION_NAME,
+				  PARAM_PROBE_NDILIB_PATH, QT_TO_UTF8(path));
+		config_save(obs_config);
+	}
+}
+
+QString Config::ProbeNdiLibVersion()
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		auto version = config_get_string(obs_config, SECTION_NAME,
+						 PARAM_PROBE_NDILIB_VERSION);
+		if (version) {
+			return QString::fromUtf8(version);
+		}
+	}
+	return QString();
+}
+
+void Config::ProbeNdiLibVersion(const QString &version)
+{
+	auto obs_config = GetGlobalConfig();
+	if (obs_config) {
+		config_set_string(obs_config, SECTION_NAME,
+				  PARAM_PROBE_NDILIB_VERSION,
+				  QT_TO_UTF8(version));
+		config_save(obs_config);
+	}
+}
+
 Config *Config::Current(bool load)
 {
 	if (!_instance) {
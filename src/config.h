@@ -18,6 +18,8 @@
 #pragma once
 
 #include <QDateTime>
+#include <QList>
+#include <QMap>
 #include <QString>
 #include <QVersionNumber>
 
@@ -42,8 +44,33 @@
  * AutoCheckForUpdates=true
  * MainOutputGroups=
  * PreviewOutputGroups=
+ * MainOutputUYVA=false
+ * PreviewOutputUYVA=false
+ * CanvasOutputs=[{"enabled":true,"name":"OBS Canvas","groups":"","scenes":{"Untitled":"<scene uuid>"},"width":1080,"height":1920}]
  * ```
  */
+
+/**
+ * One Canvas Output (see canvas-output.h).
+ */
+class CanvasOutputConfig {
+public:
+	bool Enabled = false;
+	QString Name = "OBS Canvas";
+	QString Groups;
+	/**
+	 * Scene UUIDs only mean something within their scene collection, so
+	 * the scene is remembered per collection, keyed by collection name.
+	 */
+	QMap<QString, QString> SceneUuids;
+	int Width = 1080;
+	int Height = 1920;
+
+	/** Scene of the current scene collection, or an empty string */
+	QString SceneUuid() const;
+	void SceneUuid(const QString &uuid);
+};
+
 class Config {
 public:
 	static Config *Current(bool load = true);
@@ -68,13 +95,21 @@ public:
 	 *  1 = `--DistroAV-detect-obsndi-force=on` : force OBS-NDI detected
 	 */
 	static int DetectObsNdiForce;
+	/**
+	 * `--distroav-probe-cache-ignore` : ignore the cached startup probe
+	 * results and rescan on this launch.
+	 */
+	static bool ProbeCacheIgnore;
 
 	bool OutputEnabled;
 	QString OutputName;
 	QString OutputGroups;
+	bool OutputUYVA;
 	bool PreviewOutputEnabled;
 	QString PreviewOutputName;
 	QString PreviewOutputGroups;
+	bool PreviewOutputUYVA;
+	QList<CanvasOutputConfig> CanvasOutputs;
 	bool TallyProgramEnabled;
 	bool TallyPreviewEnabled;
 
@@ -87,6 +122,21 @@ public:
 	int MinAutoUpdateCheckIntervalSeconds();
 	void MinAutoUpdateCheckIntervalSeconds(int seconds);
 
+	/**
+	 * Cached results of the one-time startup probes.
+	 * Each `*Dirs` value is the `;` separated list of `<path>|<mtime>`
+	 * entries that the probe scanned; the cached result is only valid while
+	 * none of those directories has changed.
+	 */
+	QString ProbeObsNdiDirs();
+	bool ProbeObsNdiFound();
+	void ProbeObsNdi(const QString &dirs, bool found);
+	QString ProbeNdiLibDirs();
+	QString ProbeNdiLibPath();
+	void ProbeNdiLib(const QString &dirs, const QString &path);
+	QString ProbeNdiLibVersion();
+	void ProbeNdiLibVersion(const QString &version);
+
 	void Save();
 
 private:
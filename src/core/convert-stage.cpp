@@ -0,0 +1,214 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "convert-stage.h"
+
+#include "ndi-core.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+// Must be a power of two. More than a couple of frames queued is latency,
+// not throughput.
+#define CONVERT_STAGE_SLOTS 4
+
+typedef struct convert_stage_slot_t {
+	NDIlib_recv_instance_t receiver;
+	NDIlib_video_frame_v2_t frame;
+	uint64_t queued_ns;
+} convert_stage_slot_t;
+
+typedef struct convert_stage_stats_t {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+} convert_stage_stats_t;
+
+static uint64_t convert_stage_now_ns()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		       std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+struct convert_stage_t {
+	std::string name;
+	convert_stage_process_t process;
+	void *param;
+
+	// Written by the capture thread only
+	std::atomic<size_t> head{0};
+	// Written by the stage thread only
+	std::atomic<size_t> tail{0};
+	convert_stage_slot_t slots[CONVERT_STAGE_SLOTS];
+
+	// Counts pushed frames, like a semaphore
+	std::mutex wake_mutex;
+	std::condition_variable wake_cv;
+	size_t wake_count = 0;
+	std::atomic<bool> stopping{false};
+	std::thread thread;
+
+	// Capture hand-off, time queued and processing time
+	convert_stage_stats_t capture;
+	convert_stage_stats_t queue;
+	convert_stage_stats_t convert;
+	uint64_t dropped = 0;
+};
+
+static void convert_stage_wake(convert_stage_t *stage)
+{
+	{
+		std::lock_guard<std::mutex> lock(stage->wake_mutex);
+		stage->wake_count++;
+	}
+	stage->wake_cv.notify_one();
+}
+
+static void convert_stage_wait(convert_stage_t *stage)
+{
+	std::unique_lock<std::mutex> lock(stage->wake_mutex);
+	stage->wake_cv.wait(lock, [stage] { return stage->wake_count > 0; });
+	stage->wake_count--;
+}
+
+static void convert_stage_stats_add(convert_stage_stats_t *stats,
+				    uint64_t ns)
+{
+	stats->count++;
+	stats->total_ns += ns;
+	stats->max_ns = std::max(stats->max_ns, ns);
+}
+
+/**
+ * @return false if the queue was empty
+ */
+static bool convert_stage_pop(convert_stage_t *stage)
+{
+	size_t tail = stage->tail.load(std::memory_order_relaxed);
+	if (tail == stage->head.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	auto slot = &stage->slots[tail & (CONVERT_STAGE_SLOTS - 1)];
+	auto start_ns = convert_stage_now_ns();
+	convert_stage_stats_add(&stage->queue, start_ns - slot->queued_ns);
+
+	stage->process(stage->param, &slot->frame);
+	ndiLib->recv_free_video_v2(slot->receiver, &slot->frame);
+	convert_stage_stats_add(&stage->convert,
+				convert_stage_now_ns() - start_ns);
+
+	stage->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+static void convert_stage_thread(convert_stage_t *stage)
+{
+	ndi_core_set_thread_name("distroav: convert stage");
+	while (!stage->stopping.load(std::memory_order_acquire)) {
+		convert_stage_wait(stage);
+		while (convert_stage_pop(stage)) {
+		}
+	}
+	// Whatever the capture thread queued before stopping
+	while (convert_stage_pop(stage)) {
+	}
+}
+
+convert_stage_t *convert_stage_create(const char *name,
+				      convert_stage_process_t process,
+				      void *param)
+{
+	auto stage = new convert_stage_t();
+	stage->name = name;
+	stage->process = process;
+	stage->param = param;
+	try {
+		stage->thread = std::thread(convert_stage_thread, stage);
+	} catch (const std::system_error &e) {
+		ndi_core_log(NDI_CORE_LOG_ERROR,
+			     "'%s' convert_stage_create: cannot create thread: %s",
+			     name, e.what());
+		delete stage;
+		return nullptr;
+	}
+	return stage;
+}
+
+static void convert_stage_log_stats(convert_stage_t *stage)
+{
+	auto avg_ms = [](const convert_stage_stats_t &stats) {
+		return stats.count ? stats.total_ns / 1000000.0 /
+					     (double)stats.count
+				   : 0.0;
+	};
+	ndi_core_log(
+		NDI_CORE_LOG_INFO,
+		"'%s' convert_stage: %llu frames, %llu dropped; capture hand-off avg=%.3fms max=%.3fms; queued avg=%.3fms max=%.3fms; convert avg=%.3fms max=%.3fms",
+		stage->name.c_str(), (unsigned long long)stage->convert.count,
+		(unsigned long long)stage->dropped, avg_ms(stage->capture),
+		stage->capture.max_ns / 1000000.0, avg_ms(stage->queue),
+		stage->queue.max_ns / 1000000.0, avg_ms(stage->convert),
+		stage->convert.max_ns / 1000000.0);
+}
+
+void convert_stage_destroy(convert_stage_t *stage)
+{
+	if (!stage) {
+		return;
+	}
+
+	stage->stopping.store(true, std::memory_order_release);
+	convert_stage_wake(stage);
+	stage->thread.join();
+
+	convert_stage_log_stats(stage);
+
+	delete stage;
+}
+
+void convert_stage_push(convert_stage_t *stage,
+			NDIlib_recv_instance_t receiver,
+			const NDIlib_video_frame_v2_t *frame)
+{
+	auto start_ns = convert_stage_now_ns();
+
+	size_t head = stage->head.load(std::memory_order_relaxed);
+	if (head - stage->tail.load(std::memory_order_acquire) ==
+	    CONVERT_STAGE_SLOTS) {
+		// The convert stage is behind: never make capture wait for it
+		ndiLib->recv_free_video_v2(receiver, frame);
+		stage->dropped++;
+	} else {
+		auto slot = &stage->slots[head & (CONVERT_STAGE_SLOTS - 1)];
+		slot->receiver = receiver;
+		slot->frame = *frame;
+		slot->queued_ns = start_ns;
+		stage->head.store(head + 1, std::memory_order_release);
+		convert_stage_wake(stage);
+	}
+
+	convert_stage_stats_add(&stage->capture,
+				convert_stage_now_ns() - start_ns);
+}
@@ -0,0 +1,53 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <Processing.NDI.Lib.h>
+
+/**
+ * Second stage of a pipelined receiver: the capture thread hands over each
+ * video frame and returns to recv_capture_v3 at once, while the stage's own
+ * thread processes the frame and frees it.
+ *
+ * The queue between them is a bounded single-producer/single-consumer ring.
+ * When it is full, the capture thread drops the frame instead of waiting.
+ */
+typedef struct convert_stage_t convert_stage_t;
+
+typedef void (*convert_stage_process_t)(void *param,
+					NDIlib_video_frame_v2_t *frame);
+
+convert_stage_t *convert_stage_create(const char *name,
+				      convert_stage_process_t process,
+				      void *param);
+
+/**
+ * Processes any queued frames, stops the stage and logs its latency.
+ * Must be called before the receiver the frames came from is destroyed.
+ */
+void convert_stage_destroy(convert_stage_t *stage);
+
+/**
+ * Takes ownership of `frame`, which is freed with recv_free_video_v2.
+ * Only ever called from one (capture) thread.
+ */
+void convert_stage_push(convert_stage_t *stage,
+			NDIlib_recv_instance_t receiver,
+			const NDIlib_video_frame_v2_t *frame);
@@ -0,0 +1,60 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "ndi-core.h"
+
+#include <stdio.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+const NDIlib_v5 *ndiLib = nullptr;
+
+static ndi_core_log_handler_t log_handler = nullptr;
+
+void ndi_core_set_log_handler(ndi_core_log_handler_t handler)
+{
+	log_handler = handler;
+}
+
+void ndi_core_log(int log_level, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	if (log_handler) {
+		log_handler(log_level, format, args);
+	} else {
+		vfprintf(stderr, format, args);
+		fputc('\n', stderr);
+	}
+	va_end(args);
+}
+
+void ndi_core_set_thread_name(const char *name)
+{
+#if defined(__linux__)
+	// Linux caps thread names at 15 characters
+	char short_name[16];
+	snprintf(short_name, sizeof(short_name), "%s", name);
+	pthread_setname_np(pthread_self(), short_name);
+#elif defined(__APPLE__)
+	pthread_setname_np(name);
+#else
+	(void)name;
+#endif
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include <Processing.NDI.Lib.h>
+
+/**
+ * The NDI core is what the plugin and distroav-node share: loading the NDI
+ * runtime, receiving and sending. It depends on neither libobs nor Qt, so
+ * each host routes its logging here.
+ */
+
+// The runtime loaded by the host
+extern const NDIlib_v5 *ndiLib;
+
+// Same values as libobs' LOG_ERROR, LOG_WARNING, LOG_INFO and LOG_DEBUG
+enum {
+	NDI_CORE_LOG_ERROR = 100,
+	NDI_CORE_LOG_WARNING = 200,
+	NDI_CORE_LOG_INFO = 300,
+	NDI_CORE_LOG_DEBUG = 400,
+};
+
+typedef void (*ndi_core_log_handler_t)(int log_level, const char *format,
+				       va_list args);
+
+/**
+ * Routes core log messages to `handler`; nullptr logs to stderr.
+ * Must be called before any core thread is started.
+ */
+void ndi_core_set_log_handler(ndi_core_log_handler_t handler);
+
+void ndi_core_log(int log_level, const char *format, ...);
+
+// Names the calling thread in debuggers and profilers, where supported
+void ndi_core_set_thread_name(const char *name);
@@ -0,0 +1,180 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "ndi-lib.h"
+
+#include "ndi-core.h"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace fs = std::filesystem;
+
+typedef const NDIlib_v5 *(*NDIlib_v5_load_)(void);
+
+struct ndi_lib_t {
+#if defined(_WIN32)
+	HMODULE module;
+#else
+	void *handle;
+#endif
+};
+
+static std::string ndi_lib_native_path(const fs::path &path)
+{
+	return fs::path(path).make_preferred().u8string();
+}
+
+std::vector<std::string> ndi_lib_locations()
+{
+	auto locations = std::vector<std::string>();
+	auto temp_path = getenv(NDILIB_REDIST_FOLDER);
+	if (temp_path && temp_path[0]) {
+		locations.push_back(temp_path);
+	}
+#if defined(__linux__) || defined(__APPLE__)
+	// Linux, MacOS
+	// https://github.com/DistroAV/DistroAV/blob/master/lib/ndi/NDI%20SDK%20Documentation.pdf
+	// "6.1 LOCATING THE LIBRARY
+	// ... the redistributable on MacOS is installed within `/usr/local/lib` ..."
+	locations.push_back("/usr/lib");
+	locations.push_back("/usr/local/lib");
+#endif
+	return locations;
+}
+
+#if defined(__linux__)
+/**
+ * @return N for `libndi.so.N[.*]`, otherwise 0
+ */
+static int ndi_lib_version(const std::string &file_name)
+{
+	static const std::string prefix = "libndi.so.";
+	if (file_name.compare(0, prefix.size(), prefix) != 0) {
+		return 0;
+	}
+	return atoi(file_name.c_str() + prefix.size());
+}
+#endif
+
+std::string ndi_lib_find(const std::vector<std::string> &locations)
+{
+	auto lib_path = std::string();
+#if defined(__linux__)
+	// Linux
+	int max_version = 0;
+#endif
+	for (const auto &location : locations) {
+		std::error_code error;
+		auto dir = fs::absolute(fs::u8path(location), error);
+		if (error) {
+			continue;
+		}
+#if defined(__linux__)
+		// Linux
+		for (const auto &entry : fs::directory_iterator(dir, error)) {
+			if (!entry.is_regular_file(error)) {
+				continue;
+			}
+			auto file_name = entry.path().filename().u8string();
+			int version = ndi_lib_version(file_name);
+			if (version > max_version) {
+				max_version = version;
+				lib_path = entry.path().u8string();
+			}
+		}
+#else
+		// MacOS, Windows
+		auto temp_path = (dir / NDILIB_LIBRARY_NAME).lexically_normal();
+		ndi_core_log(NDI_CORE_LOG_INFO, "ndi_lib_find: Trying '%s'",
+			     ndi_lib_native_path(temp_path).c_str());
+		if (fs::is_regular_file(temp_path, error)) {
+			lib_path = temp_path.u8string();
+			break;
+		}
+#endif
+	}
+	return lib_path;
+}
+
+const NDIlib_v5 *ndi_lib_load(const std::string &lib_path,
+			      ndi_lib_t **loaded_lib)
+{
+	ndi_core_log(
+		NDI_CORE_LOG_INFO,
+		"ndi_lib_load: Found '%s'; attempting to load NDI library...",
+		ndi_lib_native_path(fs::u8path(lib_path)).c_str());
+	auto lib = new ndi_lib_t();
+#if defined(_WIN32)
+	lib->module = LoadLibraryW(fs::u8path(lib_path).c_str());
+	if (!lib->module) {
+		ndi_core_log(
+			NDI_CORE_LOG_ERROR,
+			"ndi_lib_load: ERROR: LoadLibrary failed with error %lu",
+			(unsigned long)GetLastError());
+		delete lib;
+		return nullptr;
+	}
+	auto symbol = GetProcAddress(lib->module, "NDIlib_v5_load");
+#else
+	lib->handle = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!lib->handle) {
+		ndi_core_log(
+			NDI_CORE_LOG_ERROR,
+			"ndi_lib_load: ERROR: dlopen returned the following error: '%s'",
+			dlerror());
+		delete lib;
+		return nullptr;
+	}
+	auto symbol = dlsym(lib->handle, "NDIlib_v5_load");
+#endif
+
+	ndi_core_log(NDI_CORE_LOG_INFO,
+		     "ndi_lib_load: NDI library loaded successfully");
+	NDIlib_v5_load_ lib_load = reinterpret_cast<NDIlib_v5_load_>(symbol);
+	if (lib_load == nullptr) {
+		ndi_core_log(
+			NDI_CORE_LOG_ERROR,
+			"ndi_lib_load: ERROR: NDIlib_v5_load not found in loaded library");
+#if defined(_WIN32)
+		FreeLibrary(lib->module);
+#else
+		dlclose(lib->handle);
+#endif
+		delete lib;
+		return nullptr;
+	}
+
+	ndi_core_log(NDI_CORE_LOG_INFO, "ndi_lib_load: NDIlib_v5_load found");
+	*loaded_lib = lib;
+	return lib_load();
+}
+
+void ndi_lib_unload(ndi_lib_t *loaded_lib)
+{
+	// Like QLibrary's destructor, leaves the library mapped: the runtime
+	// may still have threads winding down after NDIlib_destroy
+	delete loaded_lib;
+}
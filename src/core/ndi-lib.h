@@ -0,0 +1,58 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <Processing.NDI.Lib.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * Locating and loading the NDI runtime, shared by the plugin and the
+ * headless node so that both always pick the same library.
+ * Paths are UTF-8.
+ */
+
+typedef struct ndi_lib_t ndi_lib_t;
+
+/**
+ * @return `NDILIB_REDIST_FOLDER` (if set) followed by the platform's default
+ * install locations.
+ */
+std::vector<std::string> ndi_lib_locations();
+
+/**
+ * Scans the NDI runtime `locations` for the library to load.
+ * Linux: the highest `libndi.so.N` across all locations.
+ * MacOS, Windows: the first location containing `NDILIB_LIBRARY_NAME`.
+ * @return an empty string if none was found
+ */
+std::string ndi_lib_find(const std::vector<std::string> &locations);
+
+/**
+ * Loads the library at `lib_path` and resolves `NDIlib_v5_load`.
+ * On success `*loaded_lib` owns the library and must outlive the runtime;
+ * release it with ndi_lib_unload once the runtime is destroyed.
+ * @return nullptr on failure
+ */
+const NDIlib_v5 *ndi_lib_load(const std::string &lib_path,
+			      ndi_lib_t **loaded_lib);
+
+void ndi_lib_unload(ndi_lib_t *loaded_lib);
@@ -0,0 +1,452 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "ndi-receiver.h"
+
+#include "convert-stage.h"
+#include "ndi-core.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+struct ndi_receiver_t {
+	ndi_receiver_callbacks_t callbacks;
+	void *param;
+	std::thread thread;
+
+	// Held by the owner until ndi_receiver_stop, and by the thread
+	std::atomic<int> refs{2};
+	// Held while an output callback runs, so that stop can fence them off
+	std::mutex output_mutex;
+	std::atomic<bool> stopping{false};
+};
+
+static void ndi_receiver_release(ndi_receiver_t *receiver)
+{
+	if (receiver->refs.fetch_sub(1) == 1) {
+		delete receiver;
+	}
+}
+
+/**
+ * @return true, with output_mutex held, if the owner may still be fed
+ */
+static bool ndi_receiver_output_lock(ndi_receiver_t *receiver)
+{
+	receiver->output_mutex.lock();
+	if (!receiver->stopping) {
+		return true;
+	}
+	receiver->output_mutex.unlock();
+	return false;
+}
+
+static void ndi_receiver_output_video(ndi_receiver_t *receiver,
+				      NDIlib_video_frame_v2_t *frame)
+{
+	if (ndi_receiver_output_lock(receiver)) {
+		receiver->callbacks.video(receiver->param, frame);
+		receiver->output_mutex.unlock();
+	}
+}
+
+// Runs on the convert stage of a pipelined receiver
+static void ndi_receiver_convert_video(void *param,
+				       NDIlib_video_frame_v2_t *frame)
+{
+	ndi_receiver_output_video((ndi_receiver_t *)param, frame);
+}
+
+/**
+ * The settings a receiver was created with. Strings are copied, since the
+ * owner's may be freed once `update` is called again.
+ */
+typedef struct ndi_receiver_desc_t {
+	std::string ndi_receiver_name;
+	std::string ndi_source_name;
+	NDIlib_recv_bandwidth_e bandwidth = NDIlib_recv_bandwidth_highest;
+	NDIlib_recv_color_format_e color_format =
+		NDIlib_recv_color_format_UYVY_BGRA;
+	bool allow_video_fields = false;
+	bool framesync = false;
+} ndi_receiver_desc_t;
+
+/**
+ * Updates `desc` from `settings`, logging what changed.
+ * @return true if the NDI receiver must be re-created
+ */
+static bool ndi_receiver_desc_update(ndi_receiver_desc_t *desc,
+				     const ndi_receiver_settings_t *settings)
+{
+	const char *name = settings->name;
+	bool changed = false;
+
+	const char *ndi_receiver_name =
+		settings->ndi_receiver_name ? settings->ndi_receiver_name : "";
+	if (desc->ndi_receiver_name != ndi_receiver_name) {
+		desc->ndi_receiver_name = ndi_receiver_name;
+		changed = true;
+		ndi_core_log(NDI_CORE_LOG_INFO,
+			     "'%s' ndi_receiver_thread: ndi_receiver_name changed; Setting recv_desc.p_ndi_recv_name='%s'",
+			     name, ndi_receiver_name);
+	}
+
+	const char *ndi_source_name =
+		settings->ndi_source_name ? settings->ndi_source_name : "";
+	if (desc->ndi_source_name != ndi_source_name) {
+		desc->ndi_source_name = ndi_source_name;
+		changed = true;
+		ndi_core_log(NDI_CORE_LOG_INFO,
+			     "'%s' ndi_receiver_thread: ndi_source_name changed; Setting recv_desc.source_to_connect_to.p_ndi_name='%s'",
+			     name, ndi_source_name);
+	}
+
+	if (desc->bandwidth != settings->bandwidth) {
+		desc->bandwidth = settings->bandwidth;
+		changed = true;
+		ndi_core_log(NDI_CORE_LOG_INFO,
+			     "'%s' ndi_receiver_thread: bandwidth changed; Setting recv_desc.bandwidth='%d'",
+			     name, desc->bandwidth);
+	}
+
+	if (desc->color_format != settings->color_format) {
+		desc->color_format = settings->color_format;
+		changed = true;
+		ndi_core_log(NDI_CORE_LOG_INFO,
+			     "'%s' ndi_receiver_thread: color format changed; Setting recv_desc.color_format='%d'",
+			     name, desc->color_format);
+	}
+
+	if (desc->allow_video_fields != settings->allow_video_fields) {
+		desc->allow_video_fields = settings->allow_video_fields;
+		changed = true;
+	}
+
+	if (desc->framesync != settings->framesync) {
+		desc->framesync = settings->framesync;
+		changed = true;
+		ndi_core_log(NDI_CORE_LOG_INFO,
+			     "'%s' ndi_receiver_thread: framesync changed to %s",
+			     name, desc->framesync ? "enabled" : "disabled");
+	}
+
+	return changed;
+}
+
+static void ndi_receiver_thread(ndi_receiver_t *receiver)
+{
+	const auto &callbacks = receiver->callbacks;
+	void *param = receiver->param;
+
+	ndi_receiver_settings_t settings = {};
+	ndi_receiver_desc_t desc;
+	bool reset_ndi_receiver = true;
+	// Only for logging once the loop is left
+	std::string name;
+
+	NDIlib_recv_instance_t ndi_receiver = nullptr;
+	NDIlib_framesync_instance_t ndi_frame_sync = nullptr;
+	int64_t timestamp_audio = 0;
+	int64_t timestamp_video = 0;
+
+	// Pipelined receivers hand video frames to this stage, which owns the
+	// owner's video processing while it exists
+	convert_stage_t *video_stage = nullptr;
+	// Not retried once it fails: video is processed inline until exit
+	bool video_stage_failed = false;
+
+	while (!receiver->stopping) {
+		settings = {};
+		bool reconfigure = callbacks.update(param, &settings);
+		if (!settings.name) {
+			settings.name = "";
+		}
+		if (name != settings.name) {
+			name = settings.name;
+		}
+
+		if (ndi_receiver_desc_update(&desc, &settings)) {
+			reset_ndi_receiver = true;
+		}
+
+		if (reconfigure || (video_stage && !settings.pipelined)) {
+			convert_stage_destroy(video_stage);
+			video_stage = nullptr;
+		}
+		if (reconfigure && callbacks.reconfigure) {
+			callbacks.reconfigure(param);
+		}
+
+		if (reset_ndi_receiver) {
+			reset_ndi_receiver = false;
+
+			ndi_core_log(NDI_CORE_LOG_INFO,
+				     "'%s' ndi_receiver_thread: Resetting NDI receiver…",
+				     settings.name);
+
+			// Queued frames belong to the receiver
+			convert_stage_destroy(video_stage);
+			video_stage = nullptr;
+
+			if (ndi_frame_sync) {
+				ndiLib->framesync_destroy(ndi_frame_sync);
+				ndi_frame_sync = nullptr;
+			}
+			if (ndi_receiver) {
+				ndiLib->recv_destroy(ndi_receiver);
+				ndi_receiver = nullptr;
+			}
+
+			NDIlib_recv_create_v3_t recv_desc;
+			recv_desc.source_to_connect_to.p_ndi_name =
+				desc.ndi_source_name.c_str();
+			recv_desc.p_ndi_recv_name =
+				desc.ndi_receiver_name.c_str();
+			recv_desc.bandwidth = desc.bandwidth;
+			recv_desc.color_format = desc.color_format;
+			recv_desc.allow_video_fields = desc.allow_video_fields;
+			ndi_core_log(NDI_CORE_LOG_INFO,
+				     "'%s' ndi_receiver_thread: recv_desc = { p_ndi_recv_name='%s', source_to_connect_to.p_ndi_name='%s' }",
+				     settings.name, recv_desc.p_ndi_recv_name,
+				     recv_desc.source_to_connect_to.p_ndi_name);
+			ndi_receiver = ndiLib->recv_create_v3(&recv_desc);
+			if (!ndi_receiver) {
+				ndi_core_log(NDI_CORE_LOG_ERROR,
+					     "'%s' ndi_receiver_thread: Cannot create ndi_receiver for NDI source '%s'",
+					     settings.name,
+					     desc.ndi_source_name.c_str());
+				break;
+			}
+
+			if (callbacks.created &&
+			    ndi_receiver_output_lock(receiver)) {
+				callbacks.created(param);
+				receiver->output_mutex.unlock();
+			}
+
+			if (desc.framesync) {
+				timestamp_audio = 0;
+				timestamp_video = 0;
+				ndi_frame_sync =
+					ndiLib->framesync_create(ndi_receiver);
+				if (!ndi_frame_sync) {
+					ndi_core_log(
+						NDI_CORE_LOG_ERROR,
+						"'%s' ndi_receiver_thread: Cannot create ndi_frame_sync for NDI source '%s'",
+						settings.name,
+						desc.ndi_source_name.c_str());
+					break;
+				}
+			}
+		}
+
+		if (settings.pipelined && !video_stage && !video_stage_failed &&
+		    !ndi_frame_sync) {
+			video_stage = convert_stage_create(
+				settings.name, ndi_receiver_convert_video,
+				receiver);
+			if (!video_stage) {
+				video_stage_failed = true;
+				ndi_core_log(NDI_CORE_LOG_WARNING,
+					     "'%s' ndi_receiver_thread: pipelined receive unavailable; converting on the receive thread",
+					     settings.name);
+			}
+		}
+
+		// Micro-pause until a sender is connected
+		if (ndiLib->recv_get_no_connections(ndi_receiver) == 0) {
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(100));
+			continue;
+		}
+
+		if (callbacks.connected) {
+			callbacks.connected(param, ndi_receiver);
+		}
+
+		if (ndi_frame_sync) {
+			if (callbacks.audio2) {
+				NDIlib_audio_frame_v2_t audio_frame2 = {};
+				ndiLib->framesync_capture_audio(
+					ndi_frame_sync, &audio_frame2,
+					0, // "Your desired sample rate. 0 for “use source”."
+					0, // "Your desired channel count. 0 for “use source”."
+					1024);
+				if (audio_frame2.p_data &&
+				    audio_frame2.timestamp > timestamp_audio) {
+					timestamp_audio = audio_frame2.timestamp;
+					if (ndi_receiver_output_lock(
+						    receiver)) {
+						callbacks.audio2(param,
+								 &audio_frame2);
+						receiver->output_mutex.unlock();
+					}
+				}
+				ndiLib->framesync_free_audio(ndi_frame_sync,
+							     &audio_frame2);
+			}
+
+			NDIlib_video_frame_v2_t video_frame2 = {};
+			ndiLib->framesync_capture_video(
+				ndi_frame_sync, &video_frame2,
+				NDIlib_frame_format_type_progressive);
+			if (video_frame2.p_data &&
+			    video_frame2.timestamp > timestamp_video) {
+				timestamp_video = video_frame2.timestamp;
+				ndi_receiver_output_video(receiver,
+							  &video_frame2);
+			}
+			ndiLib->framesync_free_video(ndi_frame_sync,
+						     &video_frame2);
+
+			// TODO: More accurate sleep that subtracts the duration of this loop iteration?
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(5));
+			continue;
+		}
+
+		NDIlib_video_frame_v2_t video_frame2;
+		NDIlib_audio_frame_v3_t audio_frame3;
+		NDIlib_metadata_frame_t metadata_frame;
+		auto frame_received = ndiLib->recv_capture_v3(
+			ndi_receiver, &video_frame2,
+			callbacks.audio ? &audio_frame3 : nullptr,
+			callbacks.metadata ? &metadata_frame : nullptr, 100);
+
+		if (frame_received == NDIlib_frame_type_audio) {
+			if (ndi_receiver_output_lock(receiver)) {
+				callbacks.audio(param, &audio_frame3);
+				receiver->output_mutex.unlock();
+			}
+			ndiLib->recv_free_audio_v3(ndi_receiver, &audio_frame3);
+		} else if (frame_received == NDIlib_frame_type_video) {
+			if (video_stage) {
+				convert_stage_push(video_stage, ndi_receiver,
+						   &video_frame2);
+			} else {
+				ndi_receiver_output_video(receiver,
+							  &video_frame2);
+				ndiLib->recv_free_video_v2(ndi_receiver,
+							   &video_frame2);
+			}
+		} else if (frame_received == NDIlib_frame_type_metadata) {
+			if (ndi_receiver_output_lock(receiver)) {
+				callbacks.metadata(param, &metadata_frame);
+				receiver->output_mutex.unlock();
+			}
+			ndiLib->recv_free_metadata(ndi_receiver,
+						   &metadata_frame);
+		}
+	}
+
+	convert_stage_destroy(video_stage);
+	if (ndi_frame_sync) {
+		ndiLib->framesync_destroy(ndi_frame_sync);
+	}
+	if (ndi_receiver) {
+		ndiLib->recv_destroy(ndi_receiver);
+	}
+	ndi_core_log(NDI_CORE_LOG_INFO, "'%s' ndi_receiver_thread: NDI receiver destroyed",
+		     name.c_str());
+
+	callbacks.destroy(param);
+	ndi_receiver_release(receiver);
+}
+
+ndi_receiver_t *ndi_receiver_start(const ndi_receiver_callbacks_t *callbacks,
+				   void *param)
+{
+	auto receiver = new ndi_receiver_t();
+	receiver->callbacks = *callbacks;
+	receiver->param = param;
+	try {
+		receiver->thread = std::thread(ndi_receiver_thread, receiver);
+	} catch (const std::system_error &e) {
+		ndi_core_log(NDI_CORE_LOG_ERROR,
+			     "ndi_receiver_start: Cannot create receiver thread: %s",
+			     e.what());
+		delete receiver;
+		return nullptr;
+	}
+	return receiver;
+}
+
+//
+// Stopped receiver threads are joined by a background reaper rather than by
+// whoever stopped them.
+//
+static std::mutex reaper_mutex;
+static std::condition_variable reaper_cv;
+static std::deque<std::thread> reaper_queue;
+static std::thread reaper_thread;
+static bool reaper_stopping = false;
+
+static void ndi_receiver_reaper_loop()
+{
+	std::unique_lock<std::mutex> lock(reaper_mutex);
+	while (true) {
+		reaper_cv.wait(lock, [] {
+			return !reaper_queue.empty() || reaper_stopping;
+		});
+		if (reaper_queue.empty()) {
+			break;
+		}
+		auto thread = std::move(reaper_queue.front());
+		reaper_queue.pop_front();
+		lock.unlock();
+		thread.join();
+		lock.lock();
+	}
+}
+
+void ndi_receiver_stop(ndi_receiver_t *receiver)
+{
+	{
+		// Waits out an output callback already running
+		std::lock_guard<std::mutex> lock(receiver->output_mutex);
+		receiver->stopping = true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(reaper_mutex);
+		if (!reaper_thread.joinable()) {
+			reaper_thread = std::thread(ndi_receiver_reaper_loop);
+		}
+		reaper_queue.push_back(std::move(receiver->thread));
+		reaper_cv.notify_one();
+	}
+
+	ndi_receiver_release(receiver);
+}
+
+void ndi_receiver_reaper_flush()
+{
+	{
+		std::lock_guard<std::mutex> lock(reaper_mutex);
+		reaper_stopping = true;
+	}
+	reaper_cv.notify_one();
+	if (reaper_thread.joinable()) {
+		reaper_thread.join();
+	}
+	reaper_stopping = false;
+}
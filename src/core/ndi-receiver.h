@@ -0,0 +1,108 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <Processing.NDI.Lib.h>
+
+/**
+ * Receive path shared by the NDI Source, the NDI Grid cells and the monitors
+ * and relays of distroav-node: a thread that creates an NDI receiver from its
+ * owner's settings, re-creates it whenever they change, and hands every
+ * captured frame to the owner's callbacks.
+ *
+ * Stopping never blocks: the thread is told to stop and is joined later by a
+ * background reaper, so that callers never wait out a capture timeout or
+ * recv_destroy.
+ */
+typedef struct ndi_receiver_t ndi_receiver_t;
+
+typedef struct ndi_receiver_settings_t {
+	// Only used in log messages
+	const char *name;
+	const char *ndi_receiver_name;
+	const char *ndi_source_name;
+	NDIlib_recv_bandwidth_e bandwidth;
+	NDIlib_recv_color_format_e color_format;
+	bool allow_video_fields;
+	// Pull frames from an NDI frame synchronizer instead of capturing
+	bool framesync;
+	// Process video on a convert stage (see convert-stage.h); ignored
+	// with framesync
+	bool pipelined;
+} ndi_receiver_settings_t;
+
+/**
+ * All callbacks run on the receiver thread, apart from `video` on a
+ * pipelined receiver, which runs on its convert stage.
+ */
+typedef struct ndi_receiver_callbacks_t {
+	/**
+	 * Fills in `settings` before every capture; its strings must stay
+	 * valid until the next call. The receiver is re-created whenever a
+	 * setting other than `name` or `pipelined` changes.
+	 * @return true if the way the owner processes frames is changing:
+	 * queued video frames are processed first, then `reconfigure` is
+	 * called
+	 */
+	bool (*update)(void *param, ndi_receiver_settings_t *settings);
+	/** Optional if `update` never returns true */
+	void (*reconfigure)(void *param);
+
+	/** Optional. Called with the output lock held after a (re)connect */
+	void (*created)(void *param);
+	/** Optional. Called before every capture while a sender is connected */
+	void (*connected)(void *param, NDIlib_recv_instance_t ndi_receiver);
+
+	/**
+	 * Frame output, called with the output lock held and never once
+	 * ndi_receiver_stop has returned. Frames are freed by the caller.
+	 * Without `audio` (or `audio2` with framesync) audio is discarded.
+	 * Metadata is only captured without framesync, and only if
+	 * `metadata` is set.
+	 */
+	void (*video)(void *param, NDIlib_video_frame_v2_t *frame);
+	void (*audio)(void *param, NDIlib_audio_frame_v3_t *frame);
+	void (*audio2)(void *param, NDIlib_audio_frame_v2_t *frame);
+	void (*metadata)(void *param, NDIlib_metadata_frame_t *frame);
+
+	/** Called last, once the NDI receiver has been destroyed */
+	void (*destroy)(void *param);
+} ndi_receiver_callbacks_t;
+
+/**
+ * Starts a receiver thread. `param` belongs to the thread until it calls
+ * `destroy`.
+ * @return nullptr if the thread cannot be created; `param` then stays with
+ * the caller and no callback is ever called
+ */
+ndi_receiver_t *ndi_receiver_start(const ndi_receiver_callbacks_t *callbacks,
+				   void *param);
+
+/**
+ * Fences off the output callbacks and hands the thread to the reaper.
+ * `receiver` must not be used afterwards.
+ */
+void ndi_receiver_stop(ndi_receiver_t *receiver);
+
+/**
+ * Waits for every stopped receiver to be torn down.
+ * Must be called before the NDI runtime is destroyed.
+ */
+void ndi_receiver_reaper_flush();
@@ -0,0 +1,31 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "ndi-sender.h"
+
+#include "ndi-core.h"
+
+NDIlib_send_instance_t ndi_sender_create(const char *ndi_name,
+					 const char *groups)
+{
+	NDIlib_send_create_t send_desc;
+	send_desc.p_ndi_name = ndi_name;
+	send_desc.p_groups = (groups && groups[0]) ? groups : nullptr;
+	send_desc.clock_video = false;
+	send_desc.clock_audio = false;
+	return ndiLib->send_create(&send_desc);
+}
@@ -0,0 +1,34 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <Processing.NDI.Lib.h>
+
+/**
+ * Send path shared by the NDI Output, the NDI Filter, Mix-Minus and the relays
+ * of distroav-node.
+ *
+ * Senders are never clocked: frames go out at the pace they are produced
+ * (by OBS, or by the source a relay receives) rather than at a local clock.
+ * @param groups Comma separated NDI groups; nullptr or empty for the default
+ * @return nullptr on failure
+ */
+NDIlib_send_instance_t ndi_sender_create(const char *ndi_name,
+					 const char *groups);
@@ -18,6 +18,7 @@
 #include "output-settings.h"
 
 #include "plugin-main.h"
+#include "canvas-output.h"
 #include "main-output.h"
 #include "preview-output.h"
 #include "update.h"
@@ -210,6 +211,83 @@ If you are running a local build, don't forget to add your build info to the upd
 		[this](const QString &url) {
 			QDesktopServices::openUrl(QUrl(url));
 		});
+
+	connect(ui->canvasOutputList, &QComboBox::currentIndexChanged,
+		[this](int index) {
+			canvasOutputStore();
+			canvasOutputLoad(index);
+		});
+	connect(ui->canvasOutputName, &QLineEdit::textEdited,
+		[this](const QString &text) {
+			if (canvasOutputIndex >= 0) {
+				ui->canvasOutputList->setItemText(
+					canvasOutputIndex, text);
+			}
+		});
+	connect(ui->canvasOutputAdd, &QPushButton::clicked, [this]() {
+		CanvasOutputConfig canvasOutput;
+		if (!canvasOutputs.isEmpty()) {
+			canvasOutput.Name = QString("%1 %2")
+						    .arg(canvasOutput.Name)
+						    .arg(canvasOutputs.size() + 1);
+		}
+		canvasOutputs.append(canvasOutput);
+		ui->canvasOutputList->addItem(canvasOutput.Name);
+		ui->canvasOutputList->setCurrentIndex(
+			ui->canvasOutputList->count() - 1);
+	});
+	connect(ui->canvasOutputRemove, &QPushButton::clicked, [this]() {
+		int index = canvasOutputIndex;
+		if (index < 0) {
+			return;
+		}
+		// Nothing left to store for the removed entry
+		canvasOutputIndex = -1;
+		canvasOutputs.removeAt(index);
+		ui->canvasOutputList->removeItem(index);
+		canvasOutputLoad(ui->canvasOutputList->currentIndex());
+	});
+}
+
+/**
+ * Copies the Canvas Output fields into the entry they show.
+ */
+void OutputSettings::canvasOutputStore()
+{
+	if (canvasOutputIndex < 0) {
+		return;
+	}
+	auto &canvasOutput = canvasOutputs[canvasOutputIndex];
+	canvasOutput.Enabled = ui->canvasOutputEnabled->isChecked();
+	canvasOutput.Name = ui->canvasOutputName->text();
+	canvasOutput.Groups = ui->canvasOutputGroups->text();
+	// Only the current scene collection's scene is shown and replaced
+	canvasOutput.SceneUuid(ui->canvasOutputScene->currentData().toString());
+	canvasOutput.Width = ui->canvasOutputWidth->value();
+	canvasOutput.Height = ui->canvasOutputHeight->value();
+}
+
+void OutputSettings::canvasOutputLoad(int index)
+{
+	canvasOutputIndex = index;
+	bool hasEntry = index >= 0;
+	ui->canvasOutputEnabled->setEnabled(hasEntry);
+	ui->canvasOutputName->setEnabled(hasEntry);
+	ui->canvasOutputGroups->setEnabled(hasEntry);
+	ui->canvasOutputScene->setEnabled(hasEntry);
+	ui->canvasOutputWidth->setEnabled(hasEntry);
+	ui->canvasOutputHeight->setEnabled(hasEntry);
+	ui->canvasOutputRemove->setEnabled(hasEntry);
+
+	const auto canvasOutput =
+		hasEntry ? canvasOutputs[index] : CanvasOutputConfig();
+	ui->canvasOutputEnabled->setChecked(canvasOutput.Enabled);
+	ui->canvasOutputName->setText(canvasOutput.Name);
+	ui->canvasOutputGroups->setText(canvasOutput.Groups);
+	ui->canvasOutputScene->setCurrentIndex(
+		ui->canvasOutputScene->findData(canvasOutput.SceneUuid()));
+	ui->canvasOutputWidth->setValue(canvasOutput.Width);
+	ui->canvasOutputHeight->setValue(canvasOutput.Height);
 }
 
 void OutputSettings::onFormAccepted()
@@ -219,10 +297,15 @@ void OutputSettings::onFormAccepted()
 	config->OutputEnabled = ui->mainOutputGroupBox->isChecked();
 	config->OutputName = ui->mainOutputName->text();
 	config->OutputGroups = ui->mainOutputGroups->text();
+	config->OutputUYVA = ui->mainOutputUYVACheckBox->isChecked();
 
 	config->PreviewOutputEnabled = ui->previewOutputGroupBox->isChecked();
 	config->PreviewOutputName = ui->previewOutputName->text();
 	config->PreviewOutputGroups = ui->previewOutputGroups->text();
+	config->PreviewOutputUYVA = ui->previewOutputUYVACheckBox->isChecked();
+
+	canvasOutputStore();
+	config->CanvasOutputs = canvasOutputs;
 
 	config->TallyProgramEnabled = ui->tallyProgramCheckBox->isChecked();
 	config->TallyPreviewEnabled = ui->tallyPreviewCheckBox->isChecked();
@@ -234,6 +317,7 @@ void OutputSettings::onFormAccepted()
 
 	main_output_init();
 	preview_output_init();
+	canvas_output_init();
 }
 
 void OutputSettings::showEvent(QShowEvent *)
@@ -243,10 +327,30 @@ void OutputSettings::showEvent(QShowEvent *)
 	ui->mainOutputGroupBox->setChecked(config->OutputEnabled);
 	ui->mainOutputName->setText(config->OutputName);
 	ui->mainOutputGroups->setText(config->OutputGroups);
+	ui->mainOutputUYVACheckBox->setChecked(config->OutputUYVA);
 
 	ui->previewOutputGroupBox->setChecked(config->PreviewOutputEnabled);
 	ui->previewOutputName->setText(config->PreviewOutputName);
 	ui->previewOutputGroups->setText(config->PreviewOutputGroups);
+	ui->previewOutputUYVACheckBox->setChecked(config->PreviewOutputUYVA);
+
+	ui->canvasOutputScene->clear();
+	obs_frontend_source_list scenes = {};
+	obs_frontend_get_scenes(&scenes);
+	for (size_t i = 0; i < scenes.sources.num; i++) {
+		auto scene = scenes.sources.array[i];
+		ui->canvasOutputScene->addItem(obs_source_get_name(scene),
+					       obs_source_get_uuid(scene));
+	}
+	obs_frontend_source_list_free(&scenes);
+	// Unsaved edits are dropped, as for the other fields
+	canvasOutputIndex = -1;
+	canvasOutputs = config->CanvasOutputs;
+	ui->canvasOutputList->clear();
+	for (const auto &canvasOutput : canvasOutputs) {
+		ui->canvasOutputList->addItem(canvasOutput.Name);
+	}
+	canvasOutputLoad(ui->canvasOutputList->currentIndex());
 
 	ui->tallyProgramCheckBox->setChecked(config->TallyProgramEnabled);
 	ui->tallyPreviewCheckBox->setChecked(config->TallyPreviewEnabled);
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include "../config.h"
 #include "ui_output-settings.h"
 
 class OutputSettings : public QDialog {
@@ -30,5 +31,12 @@ private slots:
 	void onFormAccepted();
 
 private:
+	void canvasOutputStore();
+	void canvasOutputLoad(int index);
+
 	std::unique_ptr<Ui::OutputSettings> ui;
+	// Edited copy of Config::CanvasOutputs, saved on accept
+	QList<CanvasOutputConfig> canvasOutputs;
+	// Entry shown in the Canvas Output fields, -1 for none
+	int canvasOutputIndex = -1;
 };
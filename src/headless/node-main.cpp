@@ -0,0 +1,571 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/**
+ * distroav-node: runs DistroAV's NDI engines without OBS.
+ *
+ * Usage: distroav-node <config.ini>
+ *
+ * ```
+ * [Node]
+ * ; Optional: load this NDI runtime instead of searching for one
+ * NdiLibPath=
+ * StatsIntervalSeconds=10
+ * ; error, warning, info or debug
+ * LogLevel=info
+ *
+ * ; Advertises "Studio A" and routes its receivers to an existing source,
+ * ; without receiving or re-encoding anything on this node
+ * [route:Studio A]
+ * Source=HOST (Camera 1)
+ * Groups=
+ *
+ * ; Receives a source and periodically logs its statistics while connected
+ * [monitor:Camera 2]
+ * Source=HOST (Camera 2)
+ * ; highest, lowest or audio_only
+ * Bandwidth=lowest
+ *
+ * ; Receives a source and sends it again as "Camera 3 Relay", for receivers
+ * ; that cannot reach the original sender. Logs statistics like a monitor.
+ * [relay:Camera 3 Relay]
+ * Source=HOST (Camera 3)
+ * Groups=
+ * ; Defaults to highest for relays
+ * Bandwidth=highest
+ * ```
+ *
+ * Monitors and relays receive through the plugin's own NDI receiver, and
+ * relays send through its NDI sender (see core/). Recording is out of scope:
+ * it needs OBS's encoders and muxers, so `[record:...]` sections are rejected.
+ */
+
+#include "ndi-core.h"
+#include "ndi-lib.h"
+#include "ndi-receiver.h"
+#include "ndi-sender.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+static volatile sig_atomic_t node_stopping = 0;
+
+static void node_signal_handler(int)
+{
+	node_stopping = 1;
+}
+
+static uint64_t node_now_ns()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		       std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+//
+// Logging: everything, including the NDI core, logs through ndi_core_log
+//
+
+static int node_log_level = NDI_CORE_LOG_INFO;
+
+static const char *node_log_level_name(int log_level)
+{
+	if (log_level <= NDI_CORE_LOG_ERROR) {
+		return "error";
+	}
+	if (log_level <= NDI_CORE_LOG_WARNING) {
+		return "warning";
+	}
+	if (log_level <= NDI_CORE_LOG_INFO) {
+		return "info";
+	}
+	return "debug";
+}
+
+static void node_log(int log_level, const char *format, va_list args)
+{
+	if (log_level > node_log_level) {
+		return;
+	}
+	char message[4096];
+	vsnprintf(message, sizeof(message), format, args);
+	fprintf(stderr, "%s: [%s] %s\n", node_log_level_name(log_level),
+		NODE_DISPLAY_NAME, message);
+}
+
+//
+// Configuration: an INI file read into sections, kept in file order
+//
+
+typedef std::map<std::string, std::string> node_section_t;
+typedef std::vector<std::pair<std::string, node_section_t>> node_config_t;
+
+static std::string node_trim(const std::string &value)
+{
+	auto first = value.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos) {
+		return std::string();
+	}
+	auto last = value.find_last_not_of(" \t\r\n");
+	return value.substr(first, last - first + 1);
+}
+
+/**
+ * Reads `[section]` headers and `key=value` lines; lines starting with `;`
+ * or `#` are comments.
+ * @return false if the file cannot be read
+ */
+static bool node_config_read(const char *path, node_config_t *config)
+{
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	node_section_t *section = nullptr;
+	std::string line;
+	while (std::getline(file, line)) {
+		line = node_trim(line);
+		if (line.empty() || line[0] == ';' || line[0] == '#') {
+			continue;
+		}
+		if (line.front() == '[' && line.back() == ']') {
+			config->emplace_back(
+				node_trim(line.substr(1, line.size() - 2)),
+				node_section_t());
+			section = &config->back().second;
+			continue;
+		}
+		auto separator = line.find('=');
+		if (!section || separator == std::string::npos) {
+			continue;
+		}
+		(*section)[node_trim(line.substr(0, separator))] =
+			node_trim(line.substr(separator + 1));
+	}
+	return true;
+}
+
+static const node_section_t *node_config_section(const node_config_t &config,
+						 const char *name)
+{
+	for (const auto &section : config) {
+		if (section.first == name) {
+			return &section.second;
+		}
+	}
+	return nullptr;
+}
+
+/**
+ * @return `key` in `section`, or `default_value` if it is missing or empty
+ */
+static std::string node_config_get(const node_section_t *section,
+				   const char *key,
+				   const char *default_value = "")
+{
+	if (section) {
+		auto value = section->find(key);
+		if (value != section->end() && !value->second.empty()) {
+			return value->second;
+		}
+	}
+	return default_value;
+}
+
+//
+// Engines
+//
+
+typedef struct node_route_t {
+	std::string name;
+	std::string source_name;
+	NDIlib_routing_instance_t ndi_router;
+} node_route_t;
+
+// Monitors and relays: a relay is a monitor that sends what it receives.
+// Owned by its receiver thread once started (see ndi-receiver.h).
+typedef struct node_monitor_t {
+	const char *type;
+	std::string name;
+	std::string source_name;
+	std::string receiver_name;
+	NDIlib_recv_bandwidth_e bandwidth;
+	uint64_t stats_interval_ns;
+
+	NDIlib_send_instance_t ndi_sender;
+
+	NDIlib_recv_performance_t last_total;
+	NDIlib_recv_performance_t last_dropped;
+	uint64_t last_stats_ns;
+} node_monitor_t;
+
+static std::vector<node_route_t *> routes;
+static std::vector<ndi_receiver_t *> monitors;
+
+static bool node_route_start(node_route_t *route, const std::string &groups)
+{
+	NDIlib_routing_create_t routing_desc;
+	routing_desc.p_ndi_name = route->name.c_str();
+	routing_desc.p_groups = groups.empty() ? nullptr : groups.c_str();
+	route->ndi_router = ndiLib->routing_create(&routing_desc);
+	if (!route->ndi_router) {
+		ndi_core_log(NDI_CORE_LOG_ERROR,
+			     "route '%s': ndi router init failed",
+			     route->name.c_str());
+		return false;
+	}
+
+	NDIlib_source_t source;
+	source.p_ndi_name = route->source_name.c_str();
+	source.p_url_address = nullptr;
+	ndiLib->routing_change(route->ndi_router, &source);
+	ndi_core_log(NDI_CORE_LOG_INFO, "route '%s': routed to '%s'",
+		     route->name.c_str(), route->source_name.c_str());
+	return true;
+}
+
+static void node_route_destroy(node_route_t *route)
+{
+	if (route->ndi_router) {
+		ndiLib->routing_destroy(route->ndi_router);
+	}
+	delete route;
+}
+
+static bool node_monitor_update(void *param, ndi_receiver_settings_t *settings)
+{
+	auto monitor = (node_monitor_t *)param;
+	settings->name = monitor->name.c_str();
+	settings->ndi_receiver_name = monitor->receiver_name.c_str();
+	settings->ndi_source_name = monitor->source_name.c_str();
+	settings->bandwidth = monitor->bandwidth;
+	settings->color_format = NDIlib_recv_color_format_fastest;
+	settings->allow_video_fields = true;
+	return false;
+}
+
+static void node_monitor_created(void *param)
+{
+	auto monitor = (node_monitor_t *)param;
+	// A new receiver counts from zero
+	monitor->last_total = {};
+	monitor->last_dropped = {};
+	monitor->last_stats_ns = node_now_ns();
+}
+
+static void node_monitor_connected(void *param,
+				   NDIlib_recv_instance_t ndi_receiver)
+{
+	auto monitor = (node_monitor_t *)param;
+	auto now_ns = node_now_ns();
+	if (!monitor->stats_interval_ns ||
+	    now_ns - monitor->last_stats_ns < monitor->stats_interval_ns) {
+		return;
+	}
+
+	NDIlib_recv_performance_t total;
+	NDIlib_recv_performance_t dropped;
+	NDIlib_recv_queue_t queue;
+	ndiLib->recv_get_performance(ndi_receiver, &total, &dropped);
+	ndiLib->recv_get_queue(ndi_receiver, &queue);
+	auto connections = ndiLib->recv_get_no_connections(ndi_receiver);
+
+	double seconds = (double)(now_ns - monitor->last_stats_ns) / 1e9;
+	ndi_core_log(
+		NDI_CORE_LOG_INFO,
+		"%s '%s': connections=%d video=%.2ffps audio=%.2f/s dropped video=%lld audio=%lld queued video=%d audio=%d",
+		monitor->type, monitor->name.c_str(), connections,
+		(double)(total.video_frames -
+			 monitor->last_total.video_frames) /
+			seconds,
+		(double)(total.audio_frames -
+			 monitor->last_total.audio_frames) /
+			seconds,
+		(long long)(dropped.video_frames -
+			    monitor->last_dropped.video_frames),
+		(long long)(dropped.audio_frames -
+			    monitor->last_dropped.audio_frames),
+		queue.video_frames, queue.audio_frames);
+
+	monitor->last_total = total;
+	monitor->last_dropped = dropped;
+	monitor->last_stats_ns = now_ns;
+}
+
+// Synchronous sends are done with the frame on return, before the receiver
+// frees it
+
+static void node_monitor_video(void *param, NDIlib_video_frame_v2_t *frame)
+{
+	auto monitor = (node_monitor_t *)param;
+	if (monitor->ndi_sender) {
+		ndiLib->send_send_video_v2(monitor->ndi_sender, frame);
+	}
+}
+
+static void node_monitor_audio(void *param, NDIlib_audio_frame_v3_t *frame)
+{
+	auto monitor = (node_monitor_t *)param;
+	if (monitor->ndi_sender) {
+		ndiLib->send_send_audio_v3(monitor->ndi_sender, frame);
+	}
+}
+
+static void node_monitor_metadata(void *param, NDIlib_metadata_frame_t *frame)
+{
+	auto monitor = (node_monitor_t *)param;
+	if (monitor->ndi_sender) {
+		ndiLib->send_send_metadata(monitor->ndi_sender, frame);
+	}
+}
+
+static void node_monitor_destroy(void *param)
+{
+	auto monitor = (node_monitor_t *)param;
+	if (monitor->ndi_sender) {
+		ndiLib->send_destroy(monitor->ndi_sender);
+	}
+	delete monitor;
+}
+
+/**
+ * Starts receiving and, for a relay, sending. `monitor` belongs to its
+ * receiver thread on success, and is destroyed on failure.
+ * @param groups NDI groups a relay sends to
+ */
+static bool node_monitor_start(node_monitor_t *monitor, bool is_relay,
+			       const std::string &groups)
+{
+	monitor->receiver_name =
+		std::string(NODE_DISPLAY_NAME) + " '" + monitor->name + "'";
+
+	if (is_relay) {
+		// Paced to the received frames, not to a local clock
+		monitor->ndi_sender = ndi_sender_create(monitor->name.c_str(),
+							groups.c_str());
+		if (!monitor->ndi_sender) {
+			ndi_core_log(NDI_CORE_LOG_ERROR,
+				     "%s '%s': ndi sender init failed",
+				     monitor->type, monitor->name.c_str());
+			node_monitor_destroy(monitor);
+			return false;
+		}
+	}
+
+	ndi_receiver_callbacks_t callbacks = {};
+	callbacks.update = node_monitor_update;
+	callbacks.created = node_monitor_created;
+	callbacks.connected = node_monitor_connected;
+	callbacks.video = node_monitor_video;
+	callbacks.audio = node_monitor_audio;
+	callbacks.metadata = node_monitor_metadata;
+	callbacks.destroy = node_monitor_destroy;
+
+	auto type = monitor->type;
+	auto name = monitor->name;
+	auto source_name = monitor->source_name;
+	auto receiver = ndi_receiver_start(&callbacks, monitor);
+	if (!receiver) {
+		ndi_core_log(NDI_CORE_LOG_ERROR,
+			     "%s '%s': cannot start receiving", type,
+			     name.c_str());
+		node_monitor_destroy(monitor);
+		return false;
+	}
+	monitors.push_back(receiver);
+	ndi_core_log(NDI_CORE_LOG_INFO, "%s '%s': receiving '%s'", type,
+		     name.c_str(), source_name.c_str());
+	return true;
+}
+
+static NDIlib_recv_bandwidth_e node_parse_bandwidth(const std::string &value)
+{
+	if (value == "highest") {
+		return NDIlib_recv_bandwidth_highest;
+	}
+	if (value == "audio_only") {
+		return NDIlib_recv_bandwidth_audio_only;
+	}
+	return NDIlib_recv_bandwidth_lowest;
+}
+
+static int node_parse_log_level(const std::string &value)
+{
+	if (value == "error") {
+		return NDI_CORE_LOG_ERROR;
+	}
+	if (value == "warning") {
+		return NDI_CORE_LOG_WARNING;
+	}
+	if (value == "debug") {
+		return NDI_CORE_LOG_DEBUG;
+	}
+	return NDI_CORE_LOG_INFO;
+}
+
+/**
+ * Starts one engine per `[type:name]` section.
+ * @return false if any engine failed to start
+ */
+static bool node_start_engines(const node_config_t &config,
+			       uint64_t stats_interval_ns)
+{
+	bool ok = true;
+	for (const auto &entry : config) {
+		const char *section = entry.first.c_str();
+		const auto separator = entry.first.find(':');
+		if (separator == std::string::npos ||
+		    separator + 1 == entry.first.size()) {
+			continue;
+		}
+		auto type = entry.first.substr(0, separator);
+		auto name = entry.first.substr(separator + 1);
+
+		if (type == "record") {
+			ndi_core_log(
+				NDI_CORE_LOG_ERROR,
+				"[%s]: recording is not supported by distroav-node; it needs OBS's encoders and muxers",
+				section);
+			ok = false;
+			continue;
+		}
+
+		auto source_name = node_config_get(&entry.second, "Source");
+		if (source_name.empty()) {
+			ndi_core_log(NDI_CORE_LOG_ERROR,
+				     "[%s]: no Source configured", section);
+			ok = false;
+			continue;
+		}
+		auto groups = node_config_get(&entry.second, "Groups");
+
+		if (type == "route") {
+			auto route = new node_route_t();
+			route->name = name;
+			route->source_name = source_name;
+			routes.push_back(route);
+			ok &= node_route_start(route, groups);
+		} else if (type == "monitor" || type == "relay") {
+			const bool is_relay = type == "relay";
+			auto monitor = new node_monitor_t();
+			monitor->type = is_relay ? "relay" : "monitor";
+			monitor->name = name;
+			monitor->source_name = source_name;
+			// Relays pass on full quality unless told otherwise
+			monitor->bandwidth = node_parse_bandwidth(
+				node_config_get(&entry.second, "Bandwidth",
+						is_relay ? "highest"
+							 : "lowest"));
+			monitor->stats_interval_ns = stats_interval_ns;
+			ok &= node_monitor_start(monitor, is_relay, groups);
+		} else {
+			ndi_core_log(NDI_CORE_LOG_ERROR,
+				     "[%s]: unknown engine type '%s'",
+				     section, type.c_str());
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+static void node_stop_engines()
+{
+	for (auto receiver : monitors) {
+		ndi_receiver_stop(receiver);
+	}
+	monitors.clear();
+	// Monitors and relays are destroyed by their receiver threads
+	ndi_receiver_reaper_flush();
+
+	for (auto route : routes) {
+		node_route_destroy(route);
+	}
+	routes.clear();
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <config.ini>\n", argv[0]);
+		return 2;
+	}
+
+	node_config_t config;
+	if (!node_config_read(argv[1], &config)) {
+		fprintf(stderr, "%s: cannot read '%s'\n", argv[0], argv[1]);
+		return 2;
+	}
+	auto node_section = node_config_section(config, "Node");
+	node_log_level =
+		node_parse_log_level(node_config_get(node_section, "LogLevel"));
+	ndi_core_set_log_handler(node_log);
+
+	ndi_core_log(NDI_CORE_LOG_INFO, "distroav-node %s starting with '%s'",
+		     NODE_VERSION, argv[1]);
+
+	ndi_lib_t *loaded_lib = nullptr;
+	auto lib_path = node_config_get(node_section, "NdiLibPath");
+	if (lib_path.empty()) {
+		lib_path = ndi_lib_find(ndi_lib_locations());
+	}
+	if (!lib_path.empty()) {
+		ndiLib = ndi_lib_load(lib_path, &loaded_lib);
+	}
+	if (!ndiLib || !ndiLib->initialize()) {
+		ndi_core_log(NDI_CORE_LOG_ERROR,
+			     "Can't load the NDI runtime");
+		ndi_lib_unload(loaded_lib);
+		return 1;
+	}
+	ndi_core_log(NDI_CORE_LOG_INFO, "NDI runtime %s", ndiLib->version());
+
+	signal(SIGINT, node_signal_handler);
+	signal(SIGTERM, node_signal_handler);
+
+	auto stats_interval_seconds = node_config_get(
+		node_section, "StatsIntervalSeconds", "10");
+	const uint64_t stats_interval_ns =
+		strtoull(stats_interval_seconds.c_str(), nullptr, 10) *
+		1000000000ULL;
+
+	int result = 0;
+	if (node_start_engines(config, stats_interval_ns)) {
+		while (!node_stopping) {
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(100));
+		}
+		ndi_core_log(NDI_CORE_LOG_INFO, "distroav-node stopping");
+	} else {
+		result = 1;
+	}
+
+	node_stop_engines();
+	ndiLib->destroy();
+	ndiLib = nullptr;
+	ndi_lib_unload(loaded_lib);
+	return result;
+}
@@ -23,6 +23,7 @@ struct main_output {
 	bool is_running;
 	QString ndi_name;
 	QString ndi_groups;
+	bool uyva_enabled;
 
 	obs_source_t *current_source;
 	obs_output_t *output;
@@ -116,6 +117,7 @@ void main_output_deinit()
 		context.output = nullptr;
 		context.ndi_name.clear();
 		context.ndi_groups.clear();
+		context.uyva_enabled = false;
 		obs_log(LOG_INFO,
 			"main_output_deinit: successfully released NDI main output '%s'",
 			output_name);
@@ -131,10 +133,12 @@ void main_output_init()
 	auto output_name = config->OutputName;
 	auto output_groups = config->OutputGroups;
 	auto is_enabled = config->OutputEnabled;
+	auto uyva_enabled = config->OutputUYVA;
 
 	if (output_name.isEmpty() || //
 	    (output_name != context.ndi_name ||
-	     output_groups != context.ndi_groups)) {
+	     output_groups != context.ndi_groups ||
+	     uyva_enabled != context.uyva_enabled)) {
 		main_output_deinit();
 
 		if (!output_name.isEmpty()) {
@@ -147,6 +151,8 @@ void main_output_init()
 					    output_name_);
 			obs_data_set_string(output_settings, "ndi_groups",
 					    output_groups.toUtf8().constData());
+			obs_data_set_bool(output_settings, "uyva_enabled",
+					  uyva_enabled);
 			context.output = obs_output_create("ndi_output",
 							   "NDI Main Output",
 							   output_settings,
@@ -169,6 +175,7 @@ void main_output_init()
 
 				context.ndi_name = output_name;
 				context.ndi_groups = output_groups;
+				context.uyva_enabled = uyva_enabled;
 			} else {
 				obs_log(LOG_ERROR,
 					"main_output_init: failed to create NDI main output '%s'",
@@ -0,0 +1,429 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "mix-minus.h"
+
+#include "ndi-sender.h"
+#include "plugin-main.h"
+
+#include <util/sse-intrin.h>
+#include <util/util_uint64.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// How far behind the program mix a guest's audio may be and still be subtracted
+#define MIX_MINUS_RING_SECONDS 1
+
+typedef struct mix_minus_guest_t {
+	obs_source_t *source;
+	char *ndi_name;
+	NDIlib_send_instance_t ndi_sender;
+
+	uint32_t sample_rate;
+	size_t channels;
+
+	/**
+	 * Pre-volume audio of the guest, indexed by absolute sample position
+	 * since `ring_base_ts`, so that it can be lined up with the program mix
+	 * by timestamp.
+	 */
+	std::mutex ring_mutex;
+	float *ring[MAX_AUDIO_CHANNELS];
+	uint64_t ring_capacity;
+	uint64_t ring_base_ts;
+	uint64_t ring_end;
+
+	// Planar return, `channels` x AUDIO_OUTPUT_FRAMES
+	float *output;
+} mix_minus_guest_t;
+
+static std::mutex guests_mutex;
+static std::vector<mix_minus_guest_t *> guests;
+
+/**
+ * out = mix - guest * volume, 4 samples at a time
+ */
+static void subtract_scaled(float *out, const float *mix, const float *guest,
+			    float volume, size_t count)
+{
+	const __m128 volume_v = _mm_set1_ps(volume);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(out + i,
+			      _mm_sub_ps(_mm_loadu_ps(mix + i),
+					 _mm_mul_ps(_mm_loadu_ps(guest + i),
+						    volume_v)));
+	}
+	for (; i < count; ++i) {
+		out[i] = mix[i] - guest[i] * volume;
+	}
+}
+
+/**
+ * Writes `count` samples at absolute position `pos`; silence if `data` is null.
+ */
+static void ring_write(mix_minus_guest_t *guest, size_t channel, uint64_t pos,
+		       const float *data, uint64_t count)
+{
+	if (count > guest->ring_capacity) {
+		if (data) {
+			data += count - guest->ring_capacity;
+		}
+		pos += count - guest->ring_capacity;
+		count = guest->ring_capacity;
+	}
+	while (count) {
+		uint64_t index = pos % guest->ring_capacity;
+		uint64_t chunk = std::min(count, guest->ring_capacity - index);
+		if (data) {
+			memcpy(guest->ring[channel] + index, data,
+			       chunk * sizeof(float));
+			data += chunk;
+		} else {
+			memset(guest->ring[channel] + index, 0,
+			       chunk * sizeof(float));
+		}
+		pos += chunk;
+		count -= chunk;
+	}
+}
+
+/**
+ * Capture callbacks get the guest's audio after its filters, balance and mono
+ * downmix, and `muted` covers mute, push-to-mute and push-to-talk, so the only
+ * fader stage left to apply is the volume.
+ */
+static void mix_minus_guest_captured(void *param, obs_source_t *,
+				     const struct audio_data *audio, bool muted)
+{
+	auto guest = (mix_minus_guest_t *)param;
+	std::lock_guard<std::mutex> lock(guest->ring_mutex);
+
+	if (!guest->ring_base_ts) {
+		guest->ring_base_ts = audio->timestamp;
+	}
+	if (audio->timestamp < guest->ring_base_ts) {
+		return;
+	}
+
+	uint64_t pos = util_mul_div64(audio->timestamp - guest->ring_base_ts,
+				      guest->sample_rate, 1000000000ULL);
+	for (size_t channel = 0; channel < guest->channels; ++channel) {
+		if (pos > guest->ring_end) {
+			ring_write(guest, channel, guest->ring_end, nullptr,
+				   pos - guest->ring_end);
+		}
+		ring_write(guest, channel, pos,
+			   muted ? nullptr : (const float *)audio->data[channel],
+			   audio->frames);
+	}
+	guest->ring_end = std::max(guest->ring_end, pos + audio->frames);
+}
+
+static void ring_reset(mix_minus_guest_t *guest)
+{
+	guest->ring_base_ts = 0;
+	guest->ring_end = 0;
+	for (size_t channel = 0; channel < guest->channels; ++channel) {
+		memset(guest->ring[channel], 0,
+		       (size_t)guest->ring_capacity * sizeof(float));
+	}
+}
+
+static void mix_minus_guest_deactivated(void *param, calldata_t *)
+{
+	auto guest = (mix_minus_guest_t *)param;
+	// Audio from before the source left the program must not line up
+	// with the program mix once it is back
+	std::lock_guard<std::mutex> lock(guest->ring_mutex);
+	ring_reset(guest);
+}
+
+/**
+ * @return true if the guest's audio is part of the program mix (track 1)
+ */
+static bool mix_minus_guest_in_mix(obs_source_t *source)
+{
+	return obs_source_active(source) && !obs_source_muted(source) &&
+	       (obs_source_get_audio_mixers(source) & 1) != 0 &&
+	       obs_source_get_monitoring_type(source) !=
+		       OBS_MONITORING_TYPE_MONITOR_ONLY;
+}
+
+static void mix_minus_guest_process(mix_minus_guest_t *guest,
+				    const struct audio_data *mix)
+{
+	const uint64_t frames = mix->frames;
+	const float volume = obs_source_get_volume(guest->source);
+	// Otherwise the return is the whole program mix
+	const bool in_mix = mix_minus_guest_in_mix(guest->source);
+
+	// [begin, end) is the part of the mix for which the ring holds guest audio
+	uint64_t pos = 0;
+	uint64_t begin = 0;
+	uint64_t end = 0;
+	{
+		std::lock_guard<std::mutex> lock(guest->ring_mutex);
+		if (in_mix && guest->ring_base_ts &&
+		    mix->timestamp >= guest->ring_base_ts) {
+			pos = util_mul_div64(mix->timestamp -
+						     guest->ring_base_ts,
+					     guest->sample_rate,
+					     1000000000ULL);
+			uint64_t oldest =
+				guest->ring_end > guest->ring_capacity
+					? guest->ring_end -
+						  guest->ring_capacity
+					: 0;
+			begin = std::min(std::max(pos, oldest), pos + frames);
+			end = std::max(std::min(pos + frames, guest->ring_end),
+				       begin);
+		}
+
+		for (size_t channel = 0; channel < guest->channels; ++channel) {
+			auto in = (const float *)mix->data[channel];
+			auto out = guest->output + channel * frames;
+			if (!in) {
+				memset(out, 0, frames * sizeof(float));
+				continue;
+			}
+			uint64_t i = 0;
+			if (begin > pos) {
+				memcpy(out, in, (begin - pos) * sizeof(float));
+				i = begin - pos;
+			}
+			while (pos + i < end) {
+				uint64_t index =
+					(pos + i) % guest->ring_capacity;
+				uint64_t chunk = std::min(
+					end - pos - i,
+					guest->ring_capacity - index);
+				subtract_scaled(out + i, in + i,
+						guest->ring[channel] + index,
+						volume, chunk);
+				i += chunk;
+			}
+			if (i < frames) {
+				memcpy(out + i, in + i,
+				       (frames - i) * sizeof(float));
+			}
+		}
+	}
+
+	NDIlib_audio_frame_v3_t audio_frame = {0};
+	audio_frame.sample_rate = guest->sample_rate;
+	audio_frame.no_channels = (int)guest->channels;
+	audio_frame.timecode = mix->timestamp / 100;
+	audio_frame.no_samples = (int)frames;
+	audio_frame.channel_stride_in_bytes = (int)(frames * sizeof(float));
+	audio_frame.FourCC = NDIlib_FourCC_audio_type_FLTP;
+	audio_frame.p_data = (uint8_t *)guest->output;
+
+	ndiLib->send_send_audio_v3(guest->ndi_sender, &audio_frame);
+}
+
+static void mix_minus_mix_received(void *, size_t, struct audio_data *mix)
+{
+	// One pass over the program mix for all guests
+	std::lock_guard<std::mutex> lock(guests_mutex);
+	for (auto guest : guests) {
+		if (mix->frames <= AUDIO_OUTPUT_FRAMES) {
+			mix_minus_guest_process(guest, mix);
+		}
+	}
+}
+
+static void mix_minus_guest_destroy(mix_minus_guest_t *guest)
+{
+	if (guest->ndi_sender) {
+		ndiLib->send_destroy(guest->ndi_sender);
+	}
+	for (size_t channel = 0; channel < guest->channels; ++channel) {
+		bfree(guest->ring[channel]);
+	}
+	bfree(guest->output);
+	bfree(guest->ndi_name);
+	delete guest;
+}
+
+/**
+ * Moves a guest's output to a new NDI name. Senders are created and
+ * destroyed outside guests_mutex, which the audio thread takes on every
+ * tick, since either can block for milliseconds; only the swap is locked.
+ */
+static void mix_minus_rename_guest(obs_source_t *source, const char *ndi_name)
+{
+	auto obs_source_name = obs_source_get_name(source);
+	auto ndi_sender = ndi_sender_create(ndi_name, nullptr);
+	if (!ndi_sender) {
+		obs_log(LOG_ERROR,
+			"'%s' mix_minus_rename_guest: ndi sender init failed for '%s'",
+			obs_source_name, ndi_name);
+		return;
+	}
+	auto name = bstrdup(ndi_name);
+
+	{
+		std::lock_guard<std::mutex> lock(guests_mutex);
+		for (auto guest : guests) {
+			if (guest->source == source) {
+				obs_log(LOG_INFO,
+					"'%s' mix_minus_rename_guest: renaming mix-minus output '%s' to '%s'",
+					obs_source_name, guest->ndi_name,
+					ndi_name);
+				std::swap(guest->ndi_sender, ndi_sender);
+				std::swap(guest->ndi_name, name);
+				break;
+			}
+		}
+	}
+
+	// The previous sender and name, or the new ones if the guest is gone
+	ndiLib->send_destroy(ndi_sender);
+	bfree(name);
+}
+
+void mix_minus_set_guest(obs_source_t *source, const char *ndi_name)
+{
+	auto obs_source_name = obs_source_get_name(source);
+
+	bool is_guest = false;
+	bool is_renamed = false;
+	{
+		std::lock_guard<std::mutex> lock(guests_mutex);
+		for (auto guest : guests) {
+			if (guest->source == source) {
+				is_guest = true;
+				is_renamed =
+					strcmp(guest->ndi_name, ndi_name) != 0;
+				break;
+			}
+		}
+	}
+	if (is_renamed) {
+		mix_minus_rename_guest(source, ndi_name);
+	}
+	if (is_guest) {
+		return;
+	}
+
+	obs_audio_info oai;
+	if (!obs_get_audio_info(&oai)) {
+		obs_log(LOG_ERROR,
+			"'%s' mix_minus_set_guest: audio is not initialized",
+			obs_source_name);
+		return;
+	}
+
+	auto guest = new mix_minus_guest_t();
+	guest->source = source;
+	guest->ndi_name = bstrdup(ndi_name);
+	guest->sample_rate = oai.samples_per_sec;
+	guest->channels = get_audio_channels(oai.speakers);
+	guest->ring_capacity =
+		(uint64_t)oai.samples_per_sec * MIX_MINUS_RING_SECONDS;
+	for (size_t channel = 0; channel < guest->channels; ++channel) {
+		guest->ring[channel] = (float *)bzalloc(
+			(size_t)guest->ring_capacity * sizeof(float));
+	}
+	guest->output = (float *)bzalloc(guest->channels *
+					 AUDIO_OUTPUT_FRAMES * sizeof(float));
+	guest->ndi_sender = ndi_sender_create(ndi_name, nullptr);
+	if (!guest->ndi_sender) {
+		obs_log(LOG_ERROR,
+			"'%s' mix_minus_set_guest: ndi sender init failed for '%s'",
+			obs_source_name, ndi_name);
+		mix_minus_guest_destroy(guest);
+		return;
+	}
+
+	obs_log(LOG_INFO,
+		"'%s' mix_minus_set_guest: starting mix-minus output '%s'",
+		obs_source_name, ndi_name);
+
+	obs_source_add_audio_capture_callback(source, mix_minus_guest_captured,
+					      guest);
+	signal_handler_connect(obs_source_get_signal_handler(source),
+			       "deactivate", mix_minus_guest_deactivated,
+			       guest);
+
+	bool is_first = false;
+	{
+		std::lock_guard<std::mutex> lock(guests_mutex);
+		is_first = guests.empty();
+		guests.push_back(guest);
+	}
+	if (is_first) {
+		obs_add_raw_audio_callback(0, nullptr, mix_minus_mix_received,
+					   nullptr);
+	}
+}
+
+void mix_minus_remove_guest(obs_source_t *source)
+{
+	mix_minus_guest_t *removed = nullptr;
+	bool is_last = false;
+	{
+		std::lock_guard<std::mutex> lock(guests_mutex);
+		auto it = std::find_if(guests.begin(), guests.end(),
+				       [source](mix_minus_guest_t *guest) {
+					       return guest->source == source;
+				       });
+		if (it == guests.end()) {
+			return;
+		}
+		removed = *it;
+		guests.erase(it);
+		is_last = guests.empty();
+	}
+
+	obs_log(LOG_INFO,
+		"'%s' mix_minus_remove_guest: stopping mix-minus output '%s'",
+		obs_source_get_name(source), removed->ndi_name);
+
+	// OBS takes its own locks in these; never call them with ours held
+	if (is_last) {
+		obs_remove_raw_audio_callback(0, mix_minus_mix_received,
+					      nullptr);
+	}
+	obs_source_remove_audio_capture_callback(
+		source, mix_minus_guest_captured, removed);
+	signal_handler_disconnect(obs_source_get_signal_handler(source),
+				  "deactivate", mix_minus_guest_deactivated,
+				  removed);
+
+	mix_minus_guest_destroy(removed);
+}
+
+void mix_minus_deinit()
+{
+	std::vector<obs_source_t *> sources;
+	{
+		std::lock_guard<std::mutex> lock(guests_mutex);
+		for (auto guest : guests) {
+			sources.push_back(guest->source);
+		}
+	}
+	for (auto source : sources) {
+		mix_minus_remove_guest(source);
+	}
+}
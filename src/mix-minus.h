@@ -0,0 +1,31 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <obs.h>
+
+/**
+ * Mix-minus returns for remote guests.
+ *
+ * The program mix is taken once per audio tick, and each guest's own
+ * contribution is subtracted from it to produce that guest's return, which
+ * is sent as an audio-only NDI output named `ndi_name`.
+ */
+void mix_minus_set_guest(obs_source_t *source, const char *ndi_name);
+void mix_minus_remove_guest(obs_source_t *source);
+void mix_minus_deinit();
@@ -16,6 +16,8 @@
 ******************************************************************************/
 
 #include "plugin-main.h"
+#include "ndi-sender.h"
+#include "video-conv.h"
 
 #include <util/platform.h>
 #include <util/threading.h>
@@ -27,6 +29,7 @@
 #define TEXFORMAT GS_BGRA
 #define FLT_PROP_NAME "ndi_filter_ndiname"
 #define FLT_PROP_GROUPS "ndi_filter_ndigroups"
+#define FLT_PROP_UYVA "ndi_filter_uyva"
 
 typedef struct {
 	obs_source_t *obs_source;
@@ -50,6 +53,11 @@ typedef struct {
 	video_t *video_output;
 	bool is_audioonly;
 
+	bool uyva_enabled;
+	rgb_to_yuv_matrix_t uyva_matrix;
+	uint8_t *uyva_buffer;
+	size_t uyva_buffer_size;
+
 	uint8_t *audio_conv_buffer;
 	size_t audio_conv_buffer_size;
 } ndi_filter_t;
@@ -66,8 +74,9 @@ const char *ndi_audiofilter_getname(void *)
 
 void ndi_filter_update(void *data, obs_data_t *settings);
 
-obs_properties_t *ndi_filter_getproperties(void *)
+obs_properties_t *ndi_filter_getproperties(void *data)
 {
+	auto f = (ndi_filter_t *)data;
 	obs_log(LOG_INFO, "+ndi_filter_getproperties(...)");
 	obs_properties_t *props = obs_properties_create();
 	obs_properties_set_flags(props, OBS_PROPERTIES_DEFER_UPDATE);
@@ -82,6 +91,12 @@ obs_properties_t *ndi_filter_getproperties(void *)
 		obs_module_text("NDIPlugin.FilterProps.NDIGroups"),
 		OBS_TEXT_DEFAULT);
 
+	if (!f || !f->is_audioonly) {
+		obs_properties_add_bool(
+			props, FLT_PROP_UYVA,
+			obs_module_text("NDIPlugin.OutputProps.UYVA"));
+	}
+
 	obs_properties_add_button(
 		props, "ndi_apply",
 		obs_module_text("NDIPlugin.FilterProps.ApplySettings"),
@@ -115,6 +130,7 @@ void ndi_filter_getdefaults(obs_data_t *defaults)
 		defaults, FLT_PROP_NAME,
 		obs_module_text("NDIPlugin.FilterProps.NDIName.Default"));
 	obs_data_set_default_string(defaults, FLT_PROP_GROUPS, "");
+	obs_data_set_default_bool(defaults, FLT_PROP_UYVA, false);
 	obs_log(LOG_INFO, "-ndi_filter_getdefaults(...)");
 }
 
@@ -138,6 +154,29 @@ void ndi_filter_raw_video(void *data, video_data *frame)
 	video_frame.line_stride_in_bytes = frame->linesize[0];
 
 	pthread_mutex_lock(&f->ndi_sender_video_mutex);
+	if (f->uyva_enabled && (f->known_width % 2) == 0) {
+		// UYVY + alpha plane: 3 instead of 4 bytes per pixel into the NDI encoder
+		const uint32_t linesize = f->known_width * 2;
+		const size_t data_size =
+			(size_t)f->known_width * f->known_height * 3;
+		if (data_size > f->uyva_buffer_size) {
+			obs_log(LOG_INFO,
+				"ndi_filter_raw_video: growing uyva_buffer from %zu to %zu bytes",
+				f->uyva_buffer_size, data_size);
+			bfree(f->uyva_buffer);
+			f->uyva_buffer = (uint8_t *)bmalloc(data_size);
+			f->uyva_buffer_size = data_size;
+		}
+		convert_rgba_to_uyva(&f->uyva_matrix, frame->data[0],
+				     frame->linesize[0], f->known_width, 0,
+				     f->known_height, f->uyva_buffer, linesize,
+				     f->uyva_buffer +
+					     (size_t)linesize * f->known_height,
+				     f->known_width);
+		video_frame.FourCC = NDIlib_FourCC_type_UYVA;
+		video_frame.p_data = f->uyva_buffer;
+		video_frame.line_stride_in_bytes = linesize;
+	}
 	ndiLib->send_send_video_v2(f->ndi_sender, &video_frame);
 	pthread_mutex_unlock(&f->ndi_sender_video_mutex);
 }
@@ -191,6 +230,10 @@ void ndi_filter_offscreen_render(void *data, uint32_t, uint32_t)
 
 			video_output_close(f->video_output);
 			video_output_open(&f->video_output, &vi);
+			// UYVA is encoded with the colorspace the frames are
+			// tagged with. Not connected yet, so no lock needed.
+			rgb_to_yuv_matrix_init(&f->uyva_matrix, vi.format,
+					       vi.colorspace, vi.range);
 			video_output_connect(f->video_output, nullptr,
 					     ndi_filter_raw_video, f);
 
@@ -234,24 +277,18 @@ void ndi_filter_update(void *data, obs_data_t *settings)
 
 	obs_remove_main_render_callback(ndi_filter_offscreen_render, f);
 
-	NDIlib_send_create_t send_desc;
-	send_desc.p_ndi_name = obs_data_get_string(settings, FLT_PROP_NAME);
+	auto ndi_name = obs_data_get_string(settings, FLT_PROP_NAME);
 	auto groups = obs_data_get_string(settings, FLT_PROP_GROUPS);
-	if (groups && groups[0])
-		send_desc.p_groups = groups;
-	else
-		send_desc.p_groups = nullptr;
-	send_desc.clock_video = false;
-	send_desc.clock_audio = false;
 
 	if (!f->is_audioonly) {
 		pthread_mutex_lock(&f->ndi_sender_video_mutex);
 	}
 	pthread_mutex_lock(&f->ndi_sender_audio_mutex);
 	ndiLib->send_destroy(f->ndi_sender);
-	f->ndi_sender = ndiLib->send_create(&send_desc);
+	f->ndi_sender = ndi_sender_create(ndi_name, groups);
 	pthread_mutex_unlock(&f->ndi_sender_audio_mutex);
 	if (!f->is_audioonly) {
+		f->uyva_enabled = obs_data_get_bool(settings, FLT_PROP_UYVA);
 		pthread_mutex_unlock(&f->ndi_sender_video_mutex);
 		obs_add_main_render_callback(ndi_filter_offscreen_render, f);
 	}
@@ -322,6 +359,11 @@ void ndi_filter_destroy(void *data)
 	gs_stagesurface_destroy(f->stagesurface);
 	gs_texrender_destroy(f->texrender);
 
+	if (f->uyva_buffer) {
+		bfree(f->uyva_buffer);
+		f->uyva_buffer = nullptr;
+	}
+
 	if (f->audio_conv_buffer) {
 		obs_log(LOG_INFO, "ndi_filter_destroy: freeing %zu bytes",
 			f->audio_conv_buffer_size);
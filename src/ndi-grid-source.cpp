@@ -0,0 +1,578 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+/*
+ * "NDI Grid" source: receives up to GRID_MAX_CELLS NDI feeds and composites
+ * them on the CPU into a single canvas, which is handed to OBS as one async
+ * frame per video tick. GPU upload and per-source overhead are then constant
+ * regardless of the number of tiles.
+ */
+
+#include "plugin-main.h"
+#include "ndi-receiver.h"
+#include "video-conv.h"
+
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define PROP_GRID_ROWS "ndi_grid_rows"
+#define PROP_GRID_COLUMNS "ndi_grid_columns"
+#define PROP_GRID_WIDTH "ndi_grid_width"
+#define PROP_GRID_HEIGHT "ndi_grid_height"
+#define PROP_GRID_BANDWIDTH "ndi_grid_bw_mode"
+#define PROP_GRID_SOURCE "ndi_grid_source_%1"
+
+#define PROP_BW_HIGHEST 0
+#define PROP_BW_LOWEST 1
+
+#define GRID_MAX_ROWS 4
+#define GRID_MAX_COLUMNS 4
+#define GRID_MAX_CELLS (GRID_MAX_ROWS * GRID_MAX_COLUMNS)
+
+extern NDIlib_find_instance_t ndi_finder;
+
+typedef struct ndi_grid_cell_t {
+	char *ndi_source_name;
+
+	ndi_receiver_t *receiver;
+
+	// Cell rectangle in the canvas
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+
+	// Frame size last drawn into each canvas, to clear the letterbox on
+	// change
+	uint32_t frame_width[2];
+	uint32_t frame_height[2];
+	// Drawn into the back canvas since the last swap
+	bool drawn;
+	// Drawn into the front canvas only: the back one is a frame behind
+	bool back_stale;
+} ndi_grid_cell_t;
+
+typedef struct ndi_grid_source_t {
+	obs_source_t *obs_source;
+
+	int rows;
+	int columns;
+	NDIlib_recv_bandwidth_e bandwidth;
+
+	uint32_t width;
+	uint32_t height;
+	// Cells draw into canvases[back]; tick swaps the two and hands the
+	// front one to OBS outside canvas_mutex
+	uint8_t *canvases[2];
+	int back;
+	uint32_t canvas_linesize;
+	pthread_mutex_t canvas_mutex;
+	volatile bool canvas_dirty;
+	// Held by tick while it outputs the front canvas, and by update while
+	// it replaces the canvases. Taken before canvas_mutex.
+	pthread_mutex_t output_mutex;
+
+	// Held by the source and by each cell receiver, which may outlive it
+	volatile long refs;
+	// Serialises update, show/hide and destroy
+	pthread_mutex_t state_mutex;
+	bool running;
+
+	ndi_grid_cell_t cells[GRID_MAX_CELLS];
+} ndi_grid_source_t;
+
+// Owned by a cell receiver thread (see ndi-receiver.h)
+typedef struct ndi_grid_cell_receiver_t {
+	ndi_grid_source_t *grid;
+	int index;
+	NDIlib_recv_bandwidth_e bandwidth;
+	char *ndi_source_name;
+	char *ndi_receiver_name;
+} ndi_grid_cell_receiver_t;
+
+static void ndi_grid_release(ndi_grid_source_t *g)
+{
+	if (os_atomic_dec_long(&g->refs) > 0) {
+		return;
+	}
+	pthread_mutex_destroy(&g->canvas_mutex);
+	pthread_mutex_destroy(&g->output_mutex);
+	pthread_mutex_destroy(&g->state_mutex);
+	for (auto &cell : g->cells) {
+		bfree(cell.ndi_source_name);
+	}
+	bfree(g->canvases[0]);
+	bfree(g->canvases[1]);
+	bfree(g);
+}
+
+static void grid_clear_rect(ndi_grid_source_t *g, uint8_t *canvas, uint32_t x,
+			    uint32_t y, uint32_t width, uint32_t height)
+{
+	for (uint32_t row = y; row < y + height; ++row) {
+		auto pixel = (uint32_t *)(canvas +
+					  (size_t)row * g->canvas_linesize) +
+			     x;
+		for (uint32_t column = 0; column < width; ++column) {
+			// Opaque black in BGRA
+			pixel[column] = 0xFF000000;
+		}
+	}
+}
+
+/**
+ * Copies a cell's last drawn tile from the front canvas into the back one.
+ * Called with canvas_mutex held.
+ */
+static void grid_cell_sync_back(ndi_grid_source_t *g, ndi_grid_cell_t *cell)
+{
+	const int front = 1 - g->back;
+	for (uint32_t row = cell->y; row < cell->y + cell->height; ++row) {
+		size_t offset =
+			(size_t)row * g->canvas_linesize + (size_t)cell->x * 4;
+		memcpy(g->canvases[g->back] + offset,
+		       g->canvases[front] + offset, (size_t)cell->width * 4);
+	}
+	cell->frame_width[g->back] = cell->frame_width[front];
+	cell->frame_height[g->back] = cell->frame_height[front];
+	cell->back_stale = false;
+}
+
+static void grid_cell_draw(void *param, NDIlib_video_frame_v2_t *frame)
+{
+	auto r = (ndi_grid_cell_receiver_t *)param;
+	auto g = r->grid;
+	uint32_t frame_width = (uint32_t)frame->xres;
+	uint32_t frame_height = (uint32_t)frame->yres;
+	if (!frame->p_data || !frame_width || !frame_height) {
+		return;
+	}
+
+	// Draws are fenced off by ndi_grid_stop, so the layout cannot change
+	// under a cell; the back canvas is shared with tick
+	pthread_mutex_lock(&g->canvas_mutex);
+	auto cell = &g->cells[r->index];
+	const int back = g->back;
+	uint8_t *canvas = g->canvases[back];
+
+	// Fit the frame in the cell, keeping its aspect ratio
+	uint32_t width = cell->width;
+	uint32_t height = cell->height;
+	if ((uint64_t)frame_width * cell->height >
+	    (uint64_t)frame_height * cell->width) {
+		height = (uint32_t)((uint64_t)frame_height * cell->width /
+				    frame_width);
+	} else {
+		width = (uint32_t)((uint64_t)frame_width * cell->height /
+				   frame_height);
+	}
+	uint32_t x = cell->x + (cell->width - width) / 2;
+	uint32_t y = cell->y + (cell->height - height) / 2;
+
+	if (frame_width != cell->frame_width[back] ||
+	    frame_height != cell->frame_height[back]) {
+		cell->frame_width[back] = frame_width;
+		cell->frame_height[back] = frame_height;
+		grid_clear_rect(g, canvas, cell->x, cell->y, cell->width,
+				cell->height);
+	}
+	// BGRX leaves the fourth byte undefined
+	scale_rgba(frame->p_data, (uint32_t)frame->line_stride_in_bytes,
+		   frame_width, frame_height,
+		   canvas + (size_t)y * g->canvas_linesize + (size_t)x * 4,
+		   g->canvas_linesize, width, height,
+		   frame->FourCC == NDIlib_FourCC_video_type_BGRX);
+	// The letterbox and the tile are now both up to date in this canvas
+	cell->drawn = true;
+	cell->back_stale = false;
+	os_atomic_set_bool(&g->canvas_dirty, true);
+	pthread_mutex_unlock(&g->canvas_mutex);
+}
+
+static bool grid_cell_update(void *param, ndi_receiver_settings_t *settings)
+{
+	auto r = (ndi_grid_cell_receiver_t *)param;
+	settings->name = r->ndi_receiver_name;
+	settings->ndi_receiver_name = r->ndi_receiver_name;
+	settings->ndi_source_name = r->ndi_source_name;
+	settings->bandwidth = r->bandwidth;
+	// Packed 32 bit frames can be scaled straight into the BGRA canvas
+	settings->color_format = NDIlib_recv_color_format_BGRX_BGRA;
+	settings->allow_video_fields = false;
+	// A cell is fixed for the life of its receiver
+	return false;
+}
+
+static void grid_cell_destroy(void *param)
+{
+	auto r = (ndi_grid_cell_receiver_t *)param;
+	auto g = r->grid;
+	bfree(r->ndi_source_name);
+	bfree(r->ndi_receiver_name);
+	bfree(r);
+	ndi_grid_release(g);
+}
+
+/**
+ * Starts one receiver per configured cell; audio is discarded.
+ * Called with state_mutex held.
+ */
+static void ndi_grid_start(ndi_grid_source_t *g)
+{
+	if (g->running) {
+		return;
+	}
+	g->running = true;
+
+	ndi_receiver_callbacks_t callbacks = {};
+	callbacks.update = grid_cell_update;
+	callbacks.video = grid_cell_draw;
+	callbacks.destroy = grid_cell_destroy;
+
+	auto obs_source_name = obs_source_get_name(g->obs_source);
+	for (int i = 0; i < GRID_MAX_CELLS; ++i) {
+		auto &cell = g->cells[i];
+		if (!cell.ndi_source_name) {
+			continue;
+		}
+
+		auto r = (ndi_grid_cell_receiver_t *)bzalloc(
+			sizeof(ndi_grid_cell_receiver_t));
+		r->grid = g;
+		r->index = i;
+		r->bandwidth = g->bandwidth;
+		r->ndi_source_name = bstrdup(cell.ndi_source_name);
+		r->ndi_receiver_name = bstrdup(QT_TO_UTF8(
+			QString("%1 '%2' #%3")
+				.arg(PLUGIN_DISPLAY_NAME, obs_source_name)
+				.arg(i + 1)));
+
+		os_atomic_inc_long(&g->refs);
+		cell.receiver = ndi_receiver_start(&callbacks, r);
+		if (!cell.receiver) {
+			obs_log(LOG_ERROR,
+				"'%s' ndi_grid_start: Cannot start receiver for cell %d",
+				obs_source_name, i + 1);
+			os_atomic_dec_long(&g->refs);
+			bfree(r->ndi_source_name);
+			bfree(r->ndi_receiver_name);
+			bfree(r);
+		}
+	}
+}
+
+/**
+ * Stops every cell receiver without waiting for its thread; no cell draws
+ * once this returns.
+ * Called with state_mutex held.
+ */
+static void ndi_grid_stop(ndi_grid_source_t *g)
+{
+	if (!g->running) {
+		return;
+	}
+	g->running = false;
+
+	for (auto &cell : g->cells) {
+		if (cell.receiver) {
+			ndi_receiver_stop(cell.receiver);
+			cell.receiver = nullptr;
+		}
+	}
+}
+
+const char *ndi_grid_source_getname(void *)
+{
+	return obs_module_text("NDIPlugin.NDIGridSourceName");
+}
+
+static bool ndi_grid_layout_modified(obs_properties_t *props, obs_property_t *,
+				     obs_data_t *settings)
+{
+	int cell_count = (int)(obs_data_get_int(settings, PROP_GRID_ROWS) *
+			       obs_data_get_int(settings, PROP_GRID_COLUMNS));
+	for (int i = 0; i < GRID_MAX_CELLS; ++i) {
+		auto name = QString(PROP_GRID_SOURCE).arg(i);
+		obs_property_set_visible(
+			obs_properties_get(props, QT_TO_UTF8(name)),
+			i < cell_count);
+	}
+	return true;
+}
+
+obs_properties_t *ndi_grid_source_getproperties(void *)
+{
+	obs_log(LOG_INFO, "+ndi_grid_source_getproperties()");
+
+	obs_properties_t *props = obs_properties_create();
+
+	auto rows = obs_properties_add_int(
+		props, PROP_GRID_ROWS,
+		obs_module_text("NDIPlugin.GridProps.Rows"), 1, GRID_MAX_ROWS,
+		1);
+	obs_property_set_modified_callback(rows, ndi_grid_layout_modified);
+	auto columns = obs_properties_add_int(
+		props, PROP_GRID_COLUMNS,
+		obs_module_text("NDIPlugin.GridProps.Columns"), 1,
+		GRID_MAX_COLUMNS, 1);
+	obs_property_set_modified_callback(columns, ndi_grid_layout_modified);
+
+	obs_properties_add_int(props, PROP_GRID_WIDTH,
+			       obs_module_text("NDIPlugin.GridProps.Width"),
+			       320, 7680, 2);
+	obs_properties_add_int(props, PROP_GRID_HEIGHT,
+			       obs_module_text("NDIPlugin.GridProps.Height"),
+			       180, 4320, 2);
+
+	obs_property_t *bw_modes = obs_properties_add_list(
+		props, PROP_GRID_BANDWIDTH,
+		obs_module_text("NDIPlugin.SourceProps.Bandwidth"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(bw_modes,
+				  obs_module_text("NDIPlugin.BWMode.Lowest"),
+				  PROP_BW_LOWEST);
+	obs_property_list_add_int(bw_modes,
+				  obs_module_text("NDIPlugin.BWMode.Highest"),
+				  PROP_BW_HIGHEST);
+
+	uint32_t nbSources = 0;
+	const NDIlib_source_t *sources =
+		ndiLib->find_get_current_sources(ndi_finder, &nbSources);
+	for (int i = 0; i < GRID_MAX_CELLS; ++i) {
+		auto name = QString(PROP_GRID_SOURCE).arg(i);
+		auto description =
+			QTStr("NDIPlugin.GridProps.Cell").arg(i + 1);
+		obs_property_t *source_list = obs_properties_add_list(
+			props, QT_TO_UTF8(name), QT_TO_UTF8(description),
+			OBS_COMBO_TYPE_EDITABLE, OBS_COMBO_FORMAT_STRING);
+		for (uint32_t j = 0; j < nbSources; ++j) {
+			obs_property_list_add_string(source_list,
+						     sources[j].p_ndi_name,
+						     sources[j].p_ndi_name);
+		}
+	}
+
+	obs_log(LOG_INFO, "-ndi_grid_source_getproperties()");
+
+	return props;
+}
+
+void ndi_grid_source_getdefaults(obs_data_t *settings)
+{
+	obs_log(LOG_INFO, "+ndi_grid_source_getdefaults(…)");
+	obs_data_set_default_int(settings, PROP_GRID_ROWS, 2);
+	obs_data_set_default_int(settings, PROP_GRID_COLUMNS, 2);
+	obs_data_set_default_int(settings, PROP_GRID_WIDTH, 1920);
+	obs_data_set_default_int(settings, PROP_GRID_HEIGHT, 1080);
+	obs_data_set_default_int(settings, PROP_GRID_BANDWIDTH,
+				 PROP_BW_LOWEST);
+	obs_log(LOG_INFO, "-ndi_grid_source_getdefaults(…)");
+}
+
+void ndi_grid_source_update(void *data, obs_data_t *settings)
+{
+	auto g = (ndi_grid_source_t *)data;
+	auto obs_source_name = obs_source_get_name(g->obs_source);
+	obs_log(LOG_INFO, "'%s' +ndi_grid_source_update(…)", obs_source_name);
+
+	pthread_mutex_lock(&g->state_mutex);
+	bool was_running = g->running;
+	ndi_grid_stop(g);
+
+	g->rows = (int)obs_data_get_int(settings, PROP_GRID_ROWS);
+	g->columns = (int)obs_data_get_int(settings, PROP_GRID_COLUMNS);
+	g->bandwidth = obs_data_get_int(settings, PROP_GRID_BANDWIDTH) ==
+				       PROP_BW_HIGHEST
+			       ? NDIlib_recv_bandwidth_highest
+			       : NDIlib_recv_bandwidth_lowest;
+
+	uint32_t width = (uint32_t)obs_data_get_int(settings, PROP_GRID_WIDTH);
+	uint32_t height =
+		(uint32_t)obs_data_get_int(settings, PROP_GRID_HEIGHT);
+	// Cells are stopped, but tick may still be outputting a canvas
+	pthread_mutex_lock(&g->output_mutex);
+	pthread_mutex_lock(&g->canvas_mutex);
+	if (width != g->width || height != g->height || !g->canvases[0]) {
+		g->width = width;
+		g->height = height;
+		g->canvas_linesize = width * 4;
+		for (auto &canvas : g->canvases) {
+			bfree(canvas);
+			canvas = (uint8_t *)bmalloc(
+				(size_t)g->canvas_linesize * height);
+		}
+	}
+	for (auto canvas : g->canvases) {
+		grid_clear_rect(g, canvas, 0, 0, g->width, g->height);
+	}
+	os_atomic_set_bool(&g->canvas_dirty, true);
+
+	for (int i = 0; i < GRID_MAX_CELLS; ++i) {
+		auto &cell = g->cells[i];
+		int row = i / g->columns;
+		int column = i % g->columns;
+		cell.x = (uint32_t)(column * g->width / g->columns);
+		cell.y = (uint32_t)(row * g->height / g->rows);
+		cell.width = (uint32_t)((column + 1) * g->width / g->columns) -
+			     cell.x;
+		cell.height = (uint32_t)((row + 1) * g->height / g->rows) -
+			      cell.y;
+		cell.frame_width[0] = cell.frame_width[1] = 0;
+		cell.frame_height[0] = cell.frame_height[1] = 0;
+		cell.drawn = false;
+		cell.back_stale = false;
+
+		bfree(cell.ndi_source_name);
+		cell.ndi_source_name = nullptr;
+		if (row >= g->rows) {
+			continue;
+		}
+		auto name = QString(PROP_GRID_SOURCE).arg(i);
+		auto ndi_source_name =
+			obs_data_get_string(settings, QT_TO_UTF8(name));
+		if (ndi_source_name && ndi_source_name[0]) {
+			cell.ndi_source_name = bstrdup(ndi_source_name);
+		}
+	}
+	pthread_mutex_unlock(&g->canvas_mutex);
+	pthread_mutex_unlock(&g->output_mutex);
+
+	// Hidden grids keep no receivers; show restarts them
+	if (was_running) {
+		ndi_grid_start(g);
+	}
+	pthread_mutex_unlock(&g->state_mutex);
+
+	obs_log(LOG_INFO, "'%s' -ndi_grid_source_update(…)", obs_source_name);
+}
+
+void ndi_grid_source_tick(void *data, float)
+{
+	auto g = (ndi_grid_source_t *)data;
+	if (!os_atomic_load_bool(&g->canvas_dirty)) {
+		return;
+	}
+
+	pthread_mutex_lock(&g->output_mutex);
+	pthread_mutex_lock(&g->canvas_mutex);
+	// Tiles drawn only into the outgoing front canvas are carried over
+	// first; cells drawing every tick never need this
+	for (auto &cell : g->cells) {
+		if (cell.back_stale) {
+			grid_cell_sync_back(g, &cell);
+		}
+	}
+	g->back = 1 - g->back;
+	for (auto &cell : g->cells) {
+		cell.back_stale = cell.drawn;
+		cell.drawn = false;
+	}
+	obs_source_frame frame = {};
+	frame.format = VIDEO_FORMAT_BGRA;
+	frame.width = g->width;
+	frame.height = g->height;
+	frame.data[0] = g->canvases[1 - g->back];
+	frame.linesize[0] = g->canvas_linesize;
+	frame.timestamp = os_gettime_ns();
+	os_atomic_set_bool(&g->canvas_dirty, false);
+	pthread_mutex_unlock(&g->canvas_mutex);
+
+	// One copy of the whole canvas into OBS, whatever the number of cells;
+	// cells keep drawing into the back canvas meanwhile
+	obs_source_output_video(g->obs_source, &frame);
+	pthread_mutex_unlock(&g->output_mutex);
+}
+
+void ndi_grid_source_shown(void *data)
+{
+	auto g = (ndi_grid_source_t *)data;
+	obs_log(LOG_INFO, "'%s' ndi_grid_source_shown(…)",
+		obs_source_get_name(g->obs_source));
+	pthread_mutex_lock(&g->state_mutex);
+	ndi_grid_start(g);
+	pthread_mutex_unlock(&g->state_mutex);
+}
+
+void ndi_grid_source_hidden(void *data)
+{
+	auto g = (ndi_grid_source_t *)data;
+	obs_log(LOG_INFO, "'%s' ndi_grid_source_hidden(…)",
+		obs_source_get_name(g->obs_source));
+	pthread_mutex_lock(&g->state_mutex);
+	ndi_grid_stop(g);
+	pthread_mutex_unlock(&g->state_mutex);
+}
+
+void *ndi_grid_source_create(obs_data_t *settings, obs_source_t *obs_source)
+{
+	auto obs_source_name = obs_source_get_name(obs_source);
+	obs_log(LOG_INFO, "'%s' +ndi_grid_source_create(…)", obs_source_name);
+
+	auto g = (ndi_grid_source_t *)bzalloc(sizeof(ndi_grid_source_t));
+	g->obs_source = obs_source;
+	g->refs = 1;
+	pthread_mutex_init(&g->canvas_mutex, nullptr);
+	pthread_mutex_init(&g->output_mutex, nullptr);
+	pthread_mutex_init(&g->state_mutex, nullptr);
+
+	// Tiles are composited live; OBS buffering would only add latency
+	obs_source_set_async_unbuffered(obs_source, true);
+
+	ndi_grid_source_update(g, settings);
+
+	obs_log(LOG_INFO, "'%s' -ndi_grid_source_create(…)", obs_source_name);
+
+	return g;
+}
+
+void ndi_grid_source_destroy(void *data)
+{
+	auto g = (ndi_grid_source_t *)data;
+	auto obs_source_name = obs_source_get_name(g->obs_source);
+	obs_log(LOG_INFO, "'%s' +ndi_grid_source_destroy(…)", obs_source_name);
+
+	pthread_mutex_lock(&g->state_mutex);
+	ndi_grid_stop(g);
+	pthread_mutex_unlock(&g->state_mutex);
+
+	// Freed here or by the last cell receiver to exit
+	ndi_grid_release(g);
+
+	obs_log(LOG_INFO, "'%s' -ndi_grid_source_destroy(…)", obs_source_name);
+}
+
+obs_source_info create_ndi_grid_source_info()
+{
+	obs_source_info ndi_grid_source_info = {};
+	ndi_grid_source_info.id = "ndi_grid_source";
+	ndi_grid_source_info.type = OBS_SOURCE_TYPE_INPUT;
+	ndi_grid_source_info.output_flags = OBS_SOURCE_ASYNC_VIDEO |
+					    OBS_SOURCE_DO_NOT_DUPLICATE;
+
+	ndi_grid_source_info.get_name = ndi_grid_source_getname;
+	ndi_grid_source_info.get_properties = ndi_grid_source_getproperties;
+	ndi_grid_source_info.get_defaults = ndi_grid_source_getdefaults;
+
+	ndi_grid_source_info.create = ndi_grid_source_create;
+	ndi_grid_source_info.update = ndi_grid_source_update;
+	ndi_grid_source_info.show = ndi_grid_source_shown;
+	ndi_grid_source_info.hide = ndi_grid_source_hidden;
+	ndi_grid_source_info.video_tick = ndi_grid_source_tick;
+	ndi_grid_source_info.destroy = ndi_grid_source_destroy;
+
+	return ndi_grid_source_info;
+}
@@ -16,6 +16,8 @@
 ******************************************************************************/
 
 #include "plugin-main.h"
+#include "ndi-sender.h"
+#include "video-conv.h"
 
 static FORCE_INLINE uint32_t min_uint32(uint32_t a, uint32_t b)
 {
@@ -60,6 +62,7 @@ typedef struct {
 	const char *ndi_groups;
 	bool uses_video;
 	bool uses_audio;
+	bool uyva_enabled;
 
 	bool started;
 
@@ -73,9 +76,13 @@ typedef struct {
 	size_t audio_channels;
 	uint32_t audio_samplerate;
 
-	uint8_t *conv_buffer;
+	// send_send_video_async_v2 reads a frame until the next send, so
+	// conversions alternate between two buffers
+	uint8_t *conv_buffers[2];
+	size_t conv_buffer_index;
 	uint32_t conv_linesize;
 	uyvy_conv_function conv_function;
+	rgb_to_yuv_matrix_t uyva_matrix;
 
 	uint8_t *audio_conv_buffer;
 	size_t audio_conv_buffer_size;
@@ -101,6 +108,8 @@ obs_properties_t *ndi_output_getproperties(void *)
 		props, "ndi_groups",
 		obs_module_text("NDIPlugin.OutputProps.NDIGroups"),
 		OBS_TEXT_DEFAULT);
+	obs_properties_add_bool(props, "uyva_enabled",
+				obs_module_text("NDIPlugin.OutputProps.UYVA"));
 
 	obs_log(LOG_INFO, "-ndi_output_getproperties()");
 
@@ -116,6 +125,7 @@ void ndi_output_getdefaults(obs_data_t *settings)
 				    "DistroAV output (changeme)");
 	obs_data_set_default_bool(settings, "uses_video", true);
 	obs_data_set_default_bool(settings, "uses_audio", true);
+	obs_data_set_default_bool(settings, "uyva_enabled", false);
 	obs_log(LOG_INFO, "-ndi_output_getdefaults()");
 }
 
@@ -172,9 +182,10 @@ bool ndi_output_start(void *data)
 			o->conv_function = convert_i444_to_uyvy;
 			o->frame_fourcc = NDIlib_FourCC_video_type_UYVY;
 			o->conv_linesize = width * 2;
-			o->conv_buffer =
-				new uint8_t[(size_t)height *
-					    (size_t)o->conv_linesize * 2]();
+			for (auto &conv_buffer : o->conv_buffers) {
+				size_t size = (size_t)height * o->conv_linesize;
+				conv_buffer = new uint8_t[size * 2]();
+			}
 			break;
 
 		case VIDEO_FORMAT_NV12:
@@ -186,11 +197,26 @@ bool ndi_output_start(void *data)
 			break;
 
 		case VIDEO_FORMAT_RGBA:
-			o->frame_fourcc = NDIlib_FourCC_video_type_RGBA;
-			break;
-
 		case VIDEO_FORMAT_BGRA:
-			o->frame_fourcc = NDIlib_FourCC_video_type_BGRA;
+			if (o->uyva_enabled && (width % 2) == 0) {
+				// UYVY + alpha plane: 3 instead of 4 bytes per pixel into the NDI encoder
+				auto voi = video_output_get_info(video);
+				rgb_to_yuv_matrix_init(&o->uyva_matrix, format,
+						       voi->colorspace,
+						       voi->range);
+				o->frame_fourcc = NDIlib_FourCC_video_type_UYVA;
+				o->conv_linesize = width * 2;
+				for (auto &conv_buffer : o->conv_buffers) {
+					size_t size = (size_t)height * width;
+					conv_buffer = new uint8_t[size * 3]();
+				}
+			} else if (format == VIDEO_FORMAT_RGBA) {
+				o->frame_fourcc =
+					NDIlib_FourCC_video_type_RGBA;
+			} else {
+				o->frame_fourcc =
+					NDIlib_FourCC_video_type_BGRA;
+			}
 			break;
 
 		case VIDEO_FORMAT_BGRX:
@@ -218,16 +244,7 @@ bool ndi_output_start(void *data)
 		flags |= OBS_OUTPUT_AUDIO;
 	}
 
-	NDIlib_send_create_t send_desc;
-	send_desc.p_ndi_name = name;
-	if (groups && groups[0])
-		send_desc.p_groups = groups;
-	else
-		send_desc.p_groups = nullptr;
-	send_desc.clock_video = false;
-	send_desc.clock_audio = false;
-
-	o->ndi_sender = ndiLib->send_create(&send_desc);
+	o->ndi_sender = ndi_sender_create(name, groups);
 	if (o->ndi_sender) {
 		o->started = obs_output_begin_data_capture(o->output, flags);
 		if (o->started) {
@@ -257,6 +274,7 @@ void ndi_output_update(void *data, obs_data_t *settings)
 	o->ndi_groups = groups;
 	o->uses_video = obs_data_get_bool(settings, "uses_video");
 	o->uses_audio = obs_data_get_bool(settings, "uses_audio");
+	o->uyva_enabled = obs_data_get_bool(settings, "uyva_enabled");
 }
 
 void ndi_output_stop(void *data, uint64_t)
@@ -284,11 +302,13 @@ void ndi_output_stop(void *data, uint64_t)
 		o->ndi_sender = nullptr;
 	}
 
-	if (o->conv_buffer) {
-		delete o->conv_buffer;
-		o->conv_buffer = nullptr;
-		o->conv_function = nullptr;
+	// send_destroy has flushed the last async frame
+	for (auto &conv_buffer : o->conv_buffers) {
+		delete[] conv_buffer;
+		conv_buffer = nullptr;
 	}
+	o->conv_buffer_index = 0;
+	o->conv_function = nullptr;
 
 	o->frame_width = 0;
 	o->frame_height = 0;
@@ -339,10 +359,22 @@ void ndi_output_rawvideo(void *data, video_data *frame)
 	video_frame.timecode = frame->timestamp / 100;
 	video_frame.FourCC = o->frame_fourcc;
 
+	uint8_t *conv_buffer = o->conv_buffers[o->conv_buffer_index];
 	if (video_frame.FourCC == NDIlib_FourCC_type_UYVY) {
 		o->conv_function(frame->data, frame->linesize, 0, height,
-				 o->conv_buffer, o->conv_linesize);
-		video_frame.p_data = o->conv_buffer;
+				 conv_buffer, o->conv_linesize);
+		video_frame.p_data = conv_buffer;
+		video_frame.line_stride_in_bytes = o->conv_linesize;
+		o->conv_buffer_index ^= 1;
+	} else if (video_frame.FourCC == NDIlib_FourCC_type_UYVA) {
+		uint8_t *alpha = conv_buffer +
+				 ((size_t)height * (size_t)o->conv_linesize);
+		convert_rgba_to_uyva(&o->uyva_matrix, frame->data[0],
+				     frame->linesize[0], width, 0, height,
+				     conv_buffer, o->conv_linesize, alpha,
+				     width);
+		o->conv_buffer_index ^= 1;
+		video_frame.p_data = conv_buffer;
 		video_frame.line_stride_in_bytes = o->conv_linesize;
 	} else {
 		video_frame.p_data = frame->data[0];
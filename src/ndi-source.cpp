@@ -16,14 +16,21 @@
 ******************************************************************************/
 
 #include "plugin-main.h"
+#include "mix-minus.h"
+#include "ndi-receiver.h"
+#include "ndi-video-planes.h"
+#include "stripe-pool.h"
+#include "video-conv.h"
 
 #include <util/platform.h>
 #include <util/threading.h>
+#include <util/util_uint64.h>
 
 #include <QDesktopServices>
 #include <QUrl>
 
-#include <thread>
+#include <algorithm>
+#include <cmath>
 
 #define PROP_SOURCE "ndi_source_name"
 #define PROP_BANDWIDTH "ndi_bw_mode"
@@ -35,12 +42,17 @@
 #define PROP_FIX_ALPHA "ndi_fix_alpha_blending"
 #define PROP_YUV_RANGE "yuv_range"
 #define PROP_YUV_COLORSPACE "yuv_colorspace"
+#define PROP_UPLOAD_FORMAT "ndi_upload_format"
 #define PROP_LATENCY "latency"
 #define PROP_AUDIO "ndi_audio"
+#define PROP_AUDIO_RECHUNK "ndi_audio_rechunk"
+#define PROP_RECV_PIPELINED "ndi_recv_pipelined"
 #define PROP_PTZ "ndi_ptz"
 #define PROP_PAN "ndi_pan"
 #define PROP_TILT "ndi_tilt"
 #define PROP_ZOOM "ndi_zoom"
+#define PROP_MIXMINUS "ndi_mixminus"
+#define PROP_MIXMINUS_NAME "ndi_mixminus_name"
 
 #define PROP_BW_UNDEFINED -1
 #define PROP_BW_HIGHEST 0
@@ -61,6 +73,9 @@
 #define PROP_YUV_SPACE_BT601 1
 #define PROP_YUV_SPACE_BT709 2
 
+#define PROP_UPLOAD_FORMAT_NATIVE 0
+#define PROP_UPLOAD_FORMAT_NV12 1
+
 #define PROP_LATENCY_UNDEFINED -1
 #define PROP_LATENCY_NORMAL 0
 #define PROP_LATENCY_LOW 1
@@ -90,18 +105,22 @@ typedef struct ptz_t {
 } ptz_t;
 
 typedef struct ndi_source_config_t {
+	char *obs_source_name;
 	char *ndi_receiver_name;
-	const char *ndi_source_name;
+	char *ndi_source_name;
 	int bandwidth;
 	enum behavior_type behavior;
 	bool remember_last_frame;
 	int sync_mode;
 	bool framesync_enabled;
 	bool hw_accel_enabled;
+	bool recv_pipelined;
 	video_range_type yuv_range;
 	video_colorspace yuv_colorspace;
+	int upload_format;
 	int latency;
 	bool audio_enabled;
+	bool audio_rechunk;
 	ptz_t ptz;
 	NDIlib_tally_t tally;
 
@@ -118,17 +137,52 @@ typedef struct ndi_source_t {
 	ndi_source_config_t config;
 
 	bool running;
-	pthread_t av_thread;
+	ndi_receiver_t *receiver;
+
+	// Held by the source and by each receiver thread, which may outlive it
+	volatile long refs;
+	// Held while the name strings in config are replaced or copied
+	pthread_mutex_t config_mutex;
 
 	ndi_source_t()
 		: obs_source(nullptr),
 		  config(),
 		  running(false),
-		  av_thread()
+		  receiver(nullptr),
+		  refs(0),
+		  config_mutex()
 	{
 	}
 } ndi_source_t;
 
+static void ndi_source_release(ndi_source_t *s)
+{
+	if (os_atomic_dec_long(&s->refs) > 0) {
+		return;
+	}
+	pthread_mutex_destroy(&s->config_mutex);
+	bfree(s->config.obs_source_name);
+	bfree(s->config.ndi_receiver_name);
+	bfree(s->config.ndi_source_name);
+	bfree(s);
+}
+
+/**
+ * Keeps `*copy` equal to `name`, replacing it only when the content changes.
+ * The new copy is made before the old one is freed, so a change always
+ * yields a different pointer.
+ */
+static void ndi_source_copy_name(char **copy, const char *name)
+{
+	if (*copy == nullptr && name == nullptr)
+		return;
+	if (*copy && name && strcmp(*copy, name) == 0)
+		return;
+	auto previous = *copy;
+	*copy = bstrdup(name);
+	bfree(previous);
+}
+
 static obs_source_t *find_filter_by_id(obs_source_t *context, const char *id)
 {
 	if (!context)
@@ -271,9 +325,13 @@ obs_properties_t *ndi_source_getproperties(void *)
 			obs_property_t *yuv_colorspace =
 				obs_properties_get(props_, PROP_YUV_COLORSPACE);
 
+			obs_property_t *upload_format =
+				obs_properties_get(props_, PROP_UPLOAD_FORMAT);
+
 			obs_property_set_visible(yuv_range, !is_audio_only);
 			obs_property_set_visible(yuv_colorspace,
 						 !is_audio_only);
+			obs_property_set_visible(upload_format, !is_audio_only);
 
 			return true;
 		});
@@ -296,6 +354,10 @@ obs_properties_t *ndi_source_getproperties(void *)
 		props, PROP_HW_ACCEL,
 		obs_module_text("NDIPlugin.SourceProps.HWAccel"));
 
+	obs_properties_add_bool(
+		props, PROP_RECV_PIPELINED,
+		obs_module_text("NDIPlugin.SourceProps.RecvPipelined"));
+
 	obs_properties_add_bool(
 		props, PROP_FIX_ALPHA,
 		obs_module_text("NDIPlugin.SourceProps.AlphaBlendingFix"));
@@ -320,6 +382,19 @@ obs_properties_t *ndi_source_getproperties(void *)
 	obs_property_list_add_int(yuv_spaces, "BT.709", PROP_YUV_SPACE_BT709);
 	obs_property_list_add_int(yuv_spaces, "BT.601", PROP_YUV_SPACE_BT601);
 
+	obs_property_t *upload_formats = obs_properties_add_list(
+		props, PROP_UPLOAD_FORMAT,
+		obs_module_text("NDIPlugin.SourceProps.UploadFormat"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(
+		upload_formats,
+		obs_module_text("NDIPlugin.SourceProps.UploadFormat.Native"),
+		PROP_UPLOAD_FORMAT_NATIVE);
+	obs_property_list_add_int(
+		upload_formats,
+		obs_module_text("NDIPlugin.SourceProps.UploadFormat.NV12"),
+		PROP_UPLOAD_FORMAT_NV12);
+
 	obs_property_t *latency_modes = obs_properties_add_list(
 		props, PROP_LATENCY,
 		obs_module_text("NDIPlugin.SourceProps.Latency"),
@@ -339,6 +414,9 @@ obs_properties_t *ndi_source_getproperties(void *)
 
 	obs_properties_add_bool(props, PROP_AUDIO,
 				obs_module_text("NDIPlugin.SourceProps.Audio"));
+	obs_properties_add_bool(
+		props, PROP_AUDIO_RECHUNK,
+		obs_module_text("NDIPlugin.SourceProps.AudioRechunk"));
 
 	obs_properties_t *group_ptz = obs_properties_create();
 	obs_properties_add_float_slider(
@@ -355,6 +433,16 @@ obs_properties_t *ndi_source_getproperties(void *)
 				 obs_module_text("NDIPlugin.SourceProps.PTZ"),
 				 OBS_GROUP_CHECKABLE, group_ptz);
 
+	obs_properties_t *group_mixminus = obs_properties_create();
+	obs_properties_add_text(
+		group_mixminus, PROP_MIXMINUS_NAME,
+		obs_module_text("NDIPlugin.SourceProps.MixMinusName"),
+		OBS_TEXT_DEFAULT);
+	obs_properties_add_group(
+		props, PROP_MIXMINUS,
+		obs_module_text("NDIPlugin.SourceProps.MixMinus"),
+		OBS_GROUP_CHECKABLE, group_mixminus);
+
 	auto group_ndi = obs_properties_create();
 	obs_properties_add_button(
 		group_ndi, "ndi_website", NDI_OFFICIAL_WEB_URL,
@@ -384,8 +472,12 @@ void ndi_source_getdefaults(obs_data_t *settings)
 				 PROP_YUV_RANGE_PARTIAL);
 	obs_data_set_default_int(settings, PROP_YUV_COLORSPACE,
 				 PROP_YUV_SPACE_BT709);
+	obs_data_set_default_int(settings, PROP_UPLOAD_FORMAT,
+				 PROP_UPLOAD_FORMAT_NATIVE);
 	obs_data_set_default_int(settings, PROP_LATENCY, PROP_LATENCY_NORMAL);
 	obs_data_set_default_bool(settings, PROP_AUDIO, true);
+	obs_data_set_default_bool(settings, PROP_AUDIO_RECHUNK, true);
+	obs_data_set_default_bool(settings, PROP_RECV_PIPELINED, false);
 	obs_log(LOG_INFO, "-ndi_source_getdefaults(…)");
 }
 
@@ -399,623 +491,869 @@ void deactivate_source_output_video_texture(obs_source_t *obs_source)
 	obs_source_output_video(obs_source, NULL);
 }
 
-void ndi_source_thread_process_audio2(ndi_source_config_t *config,
-				      NDIlib_audio_frame_v2_t *ndi_audio_frame2,
-				      obs_source_t *obs_source,
-				      obs_source_audio *obs_audio_frame);
-
-void ndi_source_thread_process_audio3(ndi_source_config_t *config,
-				      NDIlib_audio_frame_v3_t *ndi_audio_frame3,
-				      obs_source_t *obs_source,
-				      obs_source_audio *obs_audio_frame);
-
-void ndi_source_thread_process_video2(ndi_source_config_t *config,
-				      NDIlib_video_frame_v2_t *ndi_video_frame2,
-				      obs_source *obs_source,
-				      obs_source_frame *obs_video_frame);
-
-void *ndi_source_thread(void *data)
+//
+// Receive pipeline: everything about how NDI frames become OBS frames that
+// only depends on the configuration is resolved once, when the thread picks up
+// a new configuration, instead of for every frame.
+//
+typedef struct ndi_source_pipeline_t {
+	void (*process_audio2)(struct ndi_source_pipeline_t *pipeline,
+			       NDIlib_audio_frame_v2_t *ndi_audio_frame,
+			       obs_source_t *obs_source);
+	void (*process_audio3)(struct ndi_source_pipeline_t *pipeline,
+			       NDIlib_audio_frame_v3_t *ndi_audio_frame,
+			       obs_source_t *obs_source);
+	// Fills video_template, which the caller then hands to OBS
+	void (*prepare_video2)(struct ndi_source_pipeline_t *pipeline,
+			       NDIlib_video_frame_v2_t *ndi_video_frame);
+
+	// Frame templates; only the per-frame fields are written on output
+	obs_source_audio audio_template;
+	int audio_channels;
+	obs_source_frame video_template;
+
+	/**
+	 * Re-chunking to the OBS audio tick: a ring per channel, spaced
+	 * `NDI_AUDIO_RECHUNK_FRAMES` apart, of samples not yet handed to OBS,
+	 * with the timestamp of the sample at `audio_read`. Its size is a
+	 * multiple of the chunk size, so a chunk never wraps.
+	 */
+	float *audio_buffer;
+	uint32_t audio_ring_size;
+	uint32_t audio_read;
+	uint32_t audio_pending;
+	uint64_t audio_pending_ts;
+	uint32_t audio_chunk_frames;
+	uint32_t audio_sample_rate;
+	uint32_t obs_sample_rate;
+
+	// obs_source_output_audio overhead and call interval jitter
+	uint64_t audio_packets_in;
+	uint64_t audio_packets_out;
+	uint64_t audio_output_ns;
+	uint64_t audio_output_max_ns;
+	uint64_t audio_output_last_ts;
+	double audio_interval_sum;
+	double audio_interval_sum_sq;
+	NDIlib_FourCC_video_type_e video_fourcc;
+	bool video_odd_width;
+	enum ndi_video_planes video_planes;
+
+	/**
+	 * UYVY repacked to NV12 before output. OBS copies the frame in
+	 * obs_source_output_video, so one buffer, reallocated only when the
+	 * frame size grows, is the whole pool.
+	 */
+	bool video_repack_nv12;
+	uint8_t *video_buffer;
+	size_t video_buffer_size;
+	// Pipelined receivers only: splits the repack of large frames
+	stripe_pool_t *video_stripe_pool;
+
+	// Repack cost versus the upload bytes it saved
+	uint64_t video_repack_frames;
+	uint64_t video_repack_ns;
+	uint64_t video_repack_bytes_in;
+	uint64_t video_repack_bytes_out;
+} ndi_source_pipeline_t;
+
+#define NDI_AUDIO_RECHUNK_FRAMES 8192
+// Frames at least this tall (4K and up) are repacked in stripes
+#define NDI_VIDEO_STRIPE_MIN_ROWS 2160
+// Stripe workers per pipelined receiver, in addition to its convert stage
+#define NDI_VIDEO_STRIPE_MAX_WORKERS 3
+// Larger gaps/overlaps between packets than this restart the interpolation
+#define NDI_AUDIO_RECHUNK_MAX_DRIFT_NS 10000000LL
+
+static void ndi_source_pipeline_output_audio(ndi_source_pipeline_t *pipeline,
+					     obs_source_t *obs_source)
 {
-	auto s = (ndi_source_t *)data;
-	auto obs_source_name = obs_source_get_name(s->obs_source);
-	obs_log(LOG_INFO, "'%s' +ndi_source_thread(…)", obs_source_name);
-
-	ndi_source_config_t config_most_recent;
-	ndi_source_config_t config_last_used;
-
-	obs_source_audio obs_audio_frame = {};
-	obs_source_frame obs_video_frame = {};
-
-	NDIlib_recv_create_v3_t recv_desc;
-	recv_desc.allow_video_fields = true;
-
-	NDIlib_recv_instance_t ndi_receiver = nullptr;
-	NDIlib_video_frame_v2_t video_frame2;
-
-	NDIlib_metadata_frame_t metadata_frame;
-	NDIlib_framesync_instance_t ndi_frame_sync = nullptr;
-	NDIlib_audio_frame_v2_t audio_frame2;
-	int64_t timestamp_audio = 0;
-	int64_t timestamp_video = 0;
-
-	NDIlib_audio_frame_v3_t audio_frame3;
-	NDIlib_frame_type_e frame_received = NDIlib_frame_type_none;
+	auto start_ns = os_gettime_ns();
+	obs_source_output_audio(obs_source, &pipeline->audio_template);
+	auto end_ns = os_gettime_ns();
+
+	auto elapsed_ns = end_ns - start_ns;
+	pipeline->audio_packets_out++;
+	pipeline->audio_output_ns += elapsed_ns;
+	if (elapsed_ns > pipeline->audio_output_max_ns) {
+		pipeline->audio_output_max_ns = elapsed_ns;
+	}
+	if (pipeline->audio_output_last_ts) {
+		double interval = (double)(start_ns -
+					   pipeline->audio_output_last_ts);
+		pipeline->audio_interval_sum += interval;
+		pipeline->audio_interval_sum_sq += interval * interval;
+	}
+	pipeline->audio_output_last_ts = start_ns;
+}
 
-	bool reset_ndi_receiver = true;
+template<int sync_mode>
+static inline uint64_t ndi_frame_timestamp(int64_t timestamp, int64_t timecode)
+{
+	return (uint64_t)((sync_mode == PROP_SYNC_NDI_TIMESTAMP ? timestamp
+							       : timecode) *
+			  100);
+}
 
-	//
-	// Main NDI receiver loop: BEGIN
-	//
-	while (s->running) {
+template<typename ndi_audio_frame_t>
+static void ndi_source_pipeline_audio_disabled(ndi_source_pipeline_t *,
+					       ndi_audio_frame_t *,
+					       obs_source_t *)
+{
+}
 
-		// semi-atomic not *TOO* heavy bit copy "snapshot"
-		config_most_recent = s->config;
+template<int sync_mode, typename ndi_audio_frame_t>
+static void ndi_source_pipeline_audio(ndi_source_pipeline_t *pipeline,
+				      ndi_audio_frame_t *ndi_audio_frame,
+				      obs_source_t *obs_source)
+{
+	auto obs_audio_frame = &pipeline->audio_template;
+
+	// The layout only changes when the sender changes its channel count
+	if (ndi_audio_frame->no_channels != pipeline->audio_channels) {
+		pipeline->audio_channels = ndi_audio_frame->no_channels;
+		const int channelCount = pipeline->audio_channels > 8
+						 ? 8
+						 : pipeline->audio_channels;
+		obs_audio_frame->speakers =
+			channel_count_to_layout(channelCount);
+		memset(obs_audio_frame->data, 0, sizeof(obs_audio_frame->data));
+	}
 
-		//
-		// Check for changes that require resetting ndi_receiver: BEGIN
-		//
+	obs_audio_frame->timestamp = ndi_frame_timestamp<sync_mode>(
+		ndi_audio_frame->timestamp, ndi_audio_frame->timecode);
+	obs_audio_frame->samples_per_sec = ndi_audio_frame->sample_rate;
+	obs_audio_frame->frames = ndi_audio_frame->no_samples;
+	const int channelCount = pipeline->audio_channels > 8
+					 ? 8
+					 : pipeline->audio_channels;
+	for (int i = 0; i < channelCount; ++i) {
+		obs_audio_frame->data[i] =
+			(uint8_t *)ndi_audio_frame->p_data +
+			(i * ndi_audio_frame->channel_stride_in_bytes);
+	}
 
-		// Fast pointer comparison is fine here; no need for slow content comparison
-		if (config_most_recent.ndi_receiver_name !=
-		    config_last_used.ndi_receiver_name) {
-			config_last_used.ndi_receiver_name =
-				config_most_recent.ndi_receiver_name;
+	pipeline->audio_packets_in++;
+	ndi_source_pipeline_output_audio(pipeline, obs_source);
+}
 
-			// If config.ndi_receiver_name changed, then so did obs_source_name
-			obs_source_name = obs_source_get_name(s->obs_source);
+/**
+ * Hands the first `frames` pending samples to OBS.
+ * They must not wrap: either one chunk, or everything pending.
+ */
+static void ndi_source_pipeline_audio_emit(ndi_source_pipeline_t *pipeline,
+					   uint32_t frames,
+					   obs_source_t *obs_source)
+{
+	auto obs_audio_frame = &pipeline->audio_template;
+	const int channelCount = pipeline->audio_channels > 8
+					 ? 8
+					 : pipeline->audio_channels;
+	for (int i = 0; i < channelCount; ++i) {
+		obs_audio_frame->data[i] =
+			(uint8_t *)(pipeline->audio_buffer +
+				    (size_t)i * NDI_AUDIO_RECHUNK_FRAMES +
+				    pipeline->audio_read);
+	}
+	obs_audio_frame->frames = frames;
+	obs_audio_frame->timestamp = pipeline->audio_pending_ts;
+	obs_audio_frame->samples_per_sec = pipeline->audio_sample_rate;
+	ndi_source_pipeline_output_audio(pipeline, obs_source);
+
+	pipeline->audio_pending -= frames;
+	pipeline->audio_pending_ts += util_mul_div64(
+		frames, 1000000000ULL, pipeline->audio_sample_rate);
+	pipeline->audio_read += frames;
+	// Wraps, or after a flush restarts on a chunk boundary
+	if (pipeline->audio_read == pipeline->audio_ring_size ||
+	    !pipeline->audio_pending) {
+		pipeline->audio_read = 0;
+	}
+}
 
-			reset_ndi_receiver = true;
+/**
+ * Appends a packet shorter than one chunk to the ring, copying in two parts
+ * when it crosses the end.
+ */
+static void
+ndi_source_pipeline_audio_append(ndi_source_pipeline_t *pipeline,
+				 NDIlib_audio_frame_v3_t *ndi_audio_frame)
+{
+	const int channelCount = pipeline->audio_channels > 8
+					 ? 8
+					 : pipeline->audio_channels;
+	const uint32_t frames = (uint32_t)ndi_audio_frame->no_samples;
+	const uint32_t write =
+		(pipeline->audio_read + pipeline->audio_pending) %
+		pipeline->audio_ring_size;
+	const uint32_t first =
+		std::min(frames, pipeline->audio_ring_size - write);
+	for (int i = 0; i < channelCount; ++i) {
+		const int stride = ndi_audio_frame->channel_stride_in_bytes;
+		auto input = (const float *)(ndi_audio_frame->p_data +
+					     i * stride);
+		auto channel = pipeline->audio_buffer +
+			       (size_t)i * NDI_AUDIO_RECHUNK_FRAMES;
+		memcpy(channel + write, input, first * sizeof(float));
+		memcpy(channel, input + first,
+		       (frames - first) * sizeof(float));
+	}
+	pipeline->audio_pending += frames;
+}
 
-			recv_desc.p_ndi_recv_name =
-				config_most_recent.ndi_receiver_name;
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: ndi_receiver_name changed; Setting recv_desc.p_ndi_recv_name='%s'",
-				obs_source_name, //
-				recv_desc.p_ndi_recv_name);
+/**
+ * Coalesces NDI packets shorter than one OBS audio tick into packets of one
+ * tick, with timestamps interpolated from the first sample. Packets of a tick
+ * or more are passed through as they are, so OBS never gets more calls than
+ * NDI delivered packets.
+ */
+template<int sync_mode>
+static void ndi_source_pipeline_audio_rechunk(
+	ndi_source_pipeline_t *pipeline,
+	NDIlib_audio_frame_v3_t *ndi_audio_frame, obs_source_t *obs_source)
+{
+	if (ndi_audio_frame->no_channels != pipeline->audio_channels ||
+	    (uint32_t)ndi_audio_frame->sample_rate !=
+		    pipeline->audio_sample_rate) {
+		if (pipeline->audio_pending) {
+			ndi_source_pipeline_audio_emit(
+				pipeline, pipeline->audio_pending, obs_source);
 		}
-
-		// Fast pointer comparison is fine here; no need for slow content comparison
-		if (config_most_recent.ndi_source_name !=
-		    config_last_used.ndi_source_name) {
-			config_last_used.ndi_source_name =
-				config_most_recent.ndi_source_name;
-
-			reset_ndi_receiver = true;
-
-			recv_desc.source_to_connect_to.p_ndi_name =
-				config_most_recent.ndi_source_name;
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: ndi_source_name changed; Setting recv_desc.source_to_connect_to.p_ndi_name='%s'",
-				obs_source_name, //
-				recv_desc.source_to_connect_to.p_ndi_name);
+		pipeline->audio_channels = ndi_audio_frame->no_channels;
+		pipeline->audio_sample_rate =
+			(uint32_t)ndi_audio_frame->sample_rate;
+		const int channelCount = pipeline->audio_channels > 8
+						 ? 8
+						 : pipeline->audio_channels;
+		pipeline->audio_template.speakers =
+			channel_count_to_layout(channelCount);
+		memset(pipeline->audio_template.data, 0,
+		       sizeof(pipeline->audio_template.data));
+		// One OBS tick worth of samples at the sender's rate
+		const uint32_t tick_frames = (uint32_t)util_mul_div64(
+			AUDIO_OUTPUT_FRAMES, pipeline->audio_sample_rate,
+			pipeline->obs_sample_rate);
+		pipeline->audio_chunk_frames =
+			std::clamp(tick_frames, 1U,
+				   (uint32_t)NDI_AUDIO_RECHUNK_FRAMES / 2);
+		// At least two chunks: pending stays below one chunk between
+		// packets, and only packets shorter than a chunk are appended
+		pipeline->audio_ring_size = NDI_AUDIO_RECHUNK_FRAMES /
+					    pipeline->audio_chunk_frames *
+					    pipeline->audio_chunk_frames;
+		if (pipeline->audio_sample_rate &&
+		    pipeline->audio_chunk_frames != tick_frames) {
+			obs_log(LOG_WARNING,
+				"'%s' ndi_source_pipeline_audio_rechunk: one OBS audio tick is %u frames at %u Hz; clamped to %u frames per chunk",
+				obs_source_get_name(obs_source), tick_frames,
+				pipeline->audio_sample_rate,
+				pipeline->audio_chunk_frames);
 		}
+	}
+	if (!pipeline->audio_sample_rate) {
+		pipeline->audio_packets_in++;
+		return;
+	}
 
-		if (config_most_recent.bandwidth !=
-		    config_last_used.bandwidth) {
-			config_last_used.bandwidth =
-				config_most_recent.bandwidth;
-
-			reset_ndi_receiver = true;
-
-			switch (config_most_recent.bandwidth) {
-			case PROP_BW_HIGHEST:
-			default:
-				recv_desc.bandwidth =
-					NDIlib_recv_bandwidth_highest;
-				break;
-			case PROP_BW_LOWEST:
-				recv_desc.bandwidth =
-					NDIlib_recv_bandwidth_lowest;
-				break;
-			case PROP_BW_AUDIO_ONLY:
-				recv_desc.bandwidth =
-					NDIlib_recv_bandwidth_audio_only;
-				break;
-			}
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: bandwidth changed; Setting recv_desc.bandwidth='%d'",
-				obs_source_name, //
-				recv_desc.bandwidth);
+	uint64_t timestamp = ndi_frame_timestamp<sync_mode>(
+		ndi_audio_frame->timestamp, ndi_audio_frame->timecode);
+	const uint32_t frames = (uint32_t)ndi_audio_frame->no_samples;
+	if (pipeline->audio_pending) {
+		int64_t expected_ts = (int64_t)(
+			pipeline->audio_pending_ts +
+			util_mul_div64(pipeline->audio_pending, 1000000000ULL,
+				       pipeline->audio_sample_rate));
+		int64_t drift_ns = (int64_t)timestamp - expected_ts;
+		if (frames >= pipeline->audio_chunk_frames ||
+		    drift_ns > NDI_AUDIO_RECHUNK_MAX_DRIFT_NS ||
+		    drift_ns < -NDI_AUDIO_RECHUNK_MAX_DRIFT_NS) {
+			ndi_source_pipeline_audio_emit(
+				pipeline, pipeline->audio_pending, obs_source);
 		}
+	}
 
-		if (config_most_recent.latency != config_last_used.latency) {
-			config_last_used.latency = config_most_recent.latency;
+	if (frames >= pipeline->audio_chunk_frames) {
+		ndi_source_pipeline_audio<sync_mode, NDIlib_audio_frame_v3_t>(
+			pipeline, ndi_audio_frame, obs_source);
+		return;
+	}
 
-			reset_ndi_receiver = true;
+	pipeline->audio_packets_in++;
+	if (!pipeline->audio_pending) {
+		pipeline->audio_pending_ts = timestamp;
+	}
+	ndi_source_pipeline_audio_append(pipeline, ndi_audio_frame);
+	if (pipeline->audio_pending >= pipeline->audio_chunk_frames) {
+		ndi_source_pipeline_audio_emit(
+			pipeline, pipeline->audio_chunk_frames, obs_source);
+	}
+}
 
-			if (config_most_recent.latency == PROP_LATENCY_NORMAL)
-				recv_desc.color_format =
-					NDIlib_recv_color_format_UYVY_BGRA;
-			else
-				recv_desc.color_format =
-					NDIlib_recv_color_format_fastest;
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: latency changed; Setting recv_desc.color_format='%d'",
-				obs_source_name, //
-				recv_desc.color_format);
-		}
+static void ndi_source_pipeline_set_video_fourcc(ndi_source_pipeline_t *pipeline,
+						 NDIlib_FourCC_video_type_e fourcc,
+						 bool odd_width)
+{
+	auto obs_video_frame = &pipeline->video_template;
+	pipeline->video_fourcc = fourcc;
+	pipeline->video_odd_width = odd_width;
+	pipeline->video_planes = NDI_VIDEO_PLANES_PACKED;
+	memset(obs_video_frame->data, 0, sizeof(obs_video_frame->data));
+	memset(obs_video_frame->linesize, 0, sizeof(obs_video_frame->linesize));
+
+	switch (fourcc) {
+	case NDIlib_FourCC_type_BGRA:
+		obs_video_frame->format = VIDEO_FORMAT_BGRA;
+		break;
 
-		if (config_most_recent.framesync_enabled !=
-		    config_last_used.framesync_enabled) {
-			config_last_used.framesync_enabled =
-				config_most_recent.framesync_enabled;
+	case NDIlib_FourCC_type_BGRX:
+		obs_video_frame->format = VIDEO_FORMAT_BGRX;
+		break;
 
-			reset_ndi_receiver = true;
+	case NDIlib_FourCC_type_RGBA:
+	case NDIlib_FourCC_type_RGBX:
+		obs_video_frame->format = VIDEO_FORMAT_RGBA;
+		break;
 
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: framesync changed to %s",
-				obs_source_name, //
-				config_most_recent.framesync_enabled
-					? "enabled"
-					: "disabled");
+	case NDIlib_FourCC_type_UYVY:
+		// NV12 chroma covers pixel pairs: odd widths stay UYVY rather
+		// than lose their last column
+		if (pipeline->video_repack_nv12 && !odd_width) {
+			obs_video_frame->format = VIDEO_FORMAT_NV12;
+			pipeline->video_planes = NDI_VIDEO_PLANES_UYVY_TO_NV12;
+		} else {
+			obs_video_frame->format = VIDEO_FORMAT_UYVY;
 		}
-		//
-		// Check for changes that require resetting ndi_receiver: END
-		//
-
-		//
-		// Conditionally reset NDI receiver: BEGIN
-		//
-		if (reset_ndi_receiver) {
-			reset_ndi_receiver = false;
-
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: reset_ndi_receiver: Resetting NDI receiver…",
-				obs_source_name);
-
-			if (ndi_frame_sync) {
-				ndiLib->framesync_destroy(ndi_frame_sync);
-				ndi_frame_sync = nullptr;
-			}
-
-			if (ndi_receiver) {
-#if 1
-				obs_log(LOG_INFO,
-					"'%s' ndi_source_thread: reset_ndi_receiver: ndiLib->recv_destroy(ndi_receiver)",
-					obs_source_name);
-#endif
-				ndiLib->recv_destroy(ndi_receiver);
-				ndi_receiver = nullptr;
-			}
-#if 1
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: reset_ndi_receiver: recv_desc = { p_ndi_recv_name='%s', source_to_connect_to.p_ndi_name='%s' }",
-				obs_source_name, //
-				recv_desc.p_ndi_recv_name,
-				recv_desc.source_to_connect_to.p_ndi_name);
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: reset_ndi_receiver: +ndi_receiver = ndiLib->recv_create_v3(&recv_desc)",
-				obs_source_name);
-#endif
-			ndi_receiver = ndiLib->recv_create_v3(&recv_desc);
-#if 1
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: reset_ndi_receiver: -ndi_receiver = ndiLib->recv_create_v3(&recv_desc)",
-				obs_source_name);
-#endif
-			if (!ndi_receiver) {
-				obs_log(LOG_ERROR,
-					"'%s' ndi_source_thread: reset_ndi_receiver: Cannot create ndi_receiver for NDI source '%s'",
-					obs_source_name, //
-					recv_desc.source_to_connect_to
-						.p_ndi_name);
-				break;
-			}
+		break;
 
-			// Deactivate the source output video texture when using Audio only
-			if (recv_desc.bandwidth ==
-			    NDIlib_recv_bandwidth_audio_only) {
-				obs_log(LOG_INFO,
-					"'%s' ndi_source_thread: reset_ndi_receiver: Audio Only: Deactivate source output video texture",
-					obs_source_name);
-				deactivate_source_output_video_texture(
-					s->obs_source);
-			}
+	case NDIlib_FourCC_type_UYVA:
+		obs_video_frame->format = VIDEO_FORMAT_UYVY;
+		break;
 
-			// Apply Framesync Settings
-			if (config_most_recent.framesync_enabled) {
-				timestamp_audio = 0;
-				timestamp_video = 0;
+	case NDIlib_FourCC_type_I420:
+		obs_video_frame->format = VIDEO_FORMAT_I420;
+		pipeline->video_planes = NDI_VIDEO_PLANES_I420;
+		break;
 
-#if 1
-				obs_log(LOG_INFO,
-					"'%s' ndi_source_thread: +ndi_frame_sync = ndiLib->framesync_create(ndi_receiver)",
-					obs_source_name);
-#endif
-				ndi_frame_sync =
-					ndiLib->framesync_create(ndi_receiver);
-#if 1
-				obs_log(LOG_INFO,
-					"'%s' ndi_source_thread: -ndi_frame_sync = ndiLib->framesync_create(ndi_receiver); ndi_frame_sync=%p",
-					obs_source_name, //
-					ndi_frame_sync);
-#endif
-				if (!ndi_frame_sync) {
-					obs_log(LOG_ERROR,
-						"'%s' ndi_source_thread: Cannot create ndi_frame_sync for NDI source '%s'",
-						obs_source_name, //
-						recv_desc.source_to_connect_to
-							.p_ndi_name);
-					break;
-				}
-			}
-		}
-		//
-		// Conditionally reset NDI receiver: END
-		//
+	case NDIlib_FourCC_type_YV12:
+		obs_video_frame->format = VIDEO_FORMAT_I420;
+		pipeline->video_planes = NDI_VIDEO_PLANES_YV12;
+		break;
 
-		//
-		// Now that we have a stable usable ndi_receiver,
-		// check if there are any connections.
-		// If not then micro-pause and restart the loop.
-		//
-		if (ndiLib->recv_get_no_connections(ndi_receiver) == 0) {
-#if 0
-			obs_log(LOG_INFO,
-			     "'%s' ndi_source_thread: No connection; sleep and restart loop",
-			     obs_source_name);
-#endif
-			//blog(LOG_INFO, "s");//leep");
-			std::this_thread::sleep_for(
-				std::chrono::milliseconds(100));
-			continue;
-		}
+	case NDIlib_FourCC_type_NV12:
+		obs_video_frame->format = VIDEO_FORMAT_NV12;
+		pipeline->video_planes = NDI_VIDEO_PLANES_NV12;
+		break;
 
-		//
-		// Change hardware acceleration
-		//
-		if (config_most_recent.hw_accel_enabled !=
-		    config_last_used.hw_accel_enabled) {
-			config_last_used.hw_accel_enabled =
-				config_most_recent.hw_accel_enabled;
+	default:
+		obs_log(LOG_WARNING,
+			"warning: unsupported video pixel format: %d", fourcc);
+		break;
+	}
+}
 
-			//
-			// From https://docs.ndi.video/docs/sdk/performance-and-implementation#receiving-video :
-			// > * In the modern versions of NDI, there are internal heuristics that attempt to guess whether hardware
-			// > acceleration would enable better performance. That said, it is possible to explicitly enable hardware
-			// > acceleration if you believe that it would be beneficial for your application. This can be enabled by
-			// > sending an XML metadata message to a receiver as follows:
-			// >	<ndi_video_codec type="hardware"/>
-			//
-			// The wording of this says very unambiguously "it is possible to explicitly enable hardware acceleration",
-			// but this can in reality only ever be a **REQUEST** to enable. The enable could fail, possibly for the
-			// obvious reason that the device may not have/support hardware acceleration.
-			//
-			// Furthermore, there is no documented way to request to *disable* hardware acceleration.
-			// I have tried setting the metadata to `<ndi_video_codec type=""/>` or `<ndi_video_codec/>` and it does not
-			// crash, but I was unable to confirm if this actually disabled hardware acceleration, and am skeptical that
-			// it could/would.
-			// So, it seems like there is no way to disable this.
-			// I have asked on the NewTek NDI SDK forum here:
-			// https://forum.vizrt.com/index.php?threads/any-way-to-explicitly-turn-off-hardware-acceleration.253766/
-			//
-			// Regardless, it makes little sense to have a checkbox that requests to enable this when
-			// checked but do nothing when unchecked.
-			// But that is what we are going to do here...
-			//
-			if (config_most_recent.hw_accel_enabled) {
-				NDIlib_metadata_frame_t hwAccelMetadata;
-				hwAccelMetadata.p_data =
-					(char *)"<ndi_video_codec type=\"hardware\"/>";
-				obs_log(LOG_INFO,
-					"ndi_source_thread: '%s' hw_accel_enabled changed to enabled; Sending NDI metadata '%s' to request hardware acceleration",
-					obs_source_name,
-					hwAccelMetadata.p_data);
-				ndiLib->recv_send_metadata(ndi_receiver,
-							   &hwAccelMetadata);
-			}
-		}
+typedef struct ndi_source_repack_args_t {
+	const uint8_t *input;
+	uint32_t in_linesize;
+	uint32_t width;
+	uint32_t height;
+	uint8_t *luma;
+	uint8_t *chroma;
+} ndi_source_repack_args_t;
+
+static void ndi_source_repack_stripe(void *param, uint32_t start_y,
+				     uint32_t end_y)
+{
+	auto args = (ndi_source_repack_args_t *)param;
+	convert_uyvy_to_nv12(args->input, args->in_linesize, args->width,
+			     args->height, start_y, end_y, args->luma,
+			     args->width, args->chroma, args->width);
+}
 
-		//
-		// Change PTZ
-		//
-		if (config_most_recent.ptz.enabled) {
-			const static float tollerance = 0.001f;
-			if (fabs(config_most_recent.ptz.pan -
-				 config_last_used.ptz.pan) > tollerance ||
-			    fabs(config_most_recent.ptz.tilt -
-				 config_last_used.ptz.tilt) > tollerance ||
-			    fabs(config_most_recent.ptz.zoom -
-				 config_last_used.ptz.zoom) > tollerance) {
-				if (ndiLib->recv_ptz_is_supported(
-					    ndi_receiver)) {
-					config_last_used.ptz =
-						config_most_recent.ptz;
+static void ndi_source_repack_nv12(ndi_source_pipeline_t *pipeline,
+				   NDIlib_video_frame_v2_t *ndi_video_frame)
+{
+	auto obs_video_frame = &pipeline->video_template;
+	// Even: odd widths are never repacked
+	const uint32_t width = ndi_video_frame->xres;
+	const uint32_t height = ndi_video_frame->yres;
+	const size_t luma_size = (size_t)width * height;
+	const size_t size = luma_size + (size_t)width * ((height + 1) / 2);
+	if (size > pipeline->video_buffer_size) {
+		bfree(pipeline->video_buffer);
+		pipeline->video_buffer = (uint8_t *)bmalloc(size);
+		pipeline->video_buffer_size = size;
+	}
 
-					obs_log(LOG_INFO,
-						"'%s' ndi_source_thread: ptz changed; Sending PTZ pan=%f, tilt=%f, zoom=%f",
-						obs_source_name, //
-						config_most_recent.ptz.pan,
-						config_most_recent.ptz.tilt,
-						config_most_recent.ptz.zoom);
-					ndiLib->recv_ptz_pan_tilt(
-						ndi_receiver,
-						config_most_recent.ptz.pan,
-						config_most_recent.ptz.tilt);
-					ndiLib->recv_ptz_zoom(
-						ndi_receiver,
-						config_most_recent.ptz.zoom);
-				}
-			}
-		}
+	ndi_source_repack_args_t repack = {
+		ndi_video_frame->p_data,
+		(uint32_t)ndi_video_frame->line_stride_in_bytes,
+		width,
+		height,
+		pipeline->video_buffer,
+		pipeline->video_buffer + luma_size,
+	};
+	auto start_ns = os_gettime_ns();
+	if (pipeline->video_stripe_pool &&
+	    height >= NDI_VIDEO_STRIPE_MIN_ROWS) {
+		// Stripes cover whole row pairs, which share chroma
+		stripe_pool_run(pipeline->video_stripe_pool, height, 2,
+				ndi_source_repack_stripe, &repack);
+	} else {
+		ndi_source_repack_stripe(&repack, 0, height);
+	}
+	pipeline->video_repack_ns += os_gettime_ns() - start_ns;
+	pipeline->video_repack_frames++;
+	pipeline->video_repack_bytes_in += luma_size * 2;
+	pipeline->video_repack_bytes_out += size;
+
+	obs_video_frame->data[0] = pipeline->video_buffer;
+	obs_video_frame->linesize[0] = width;
+	obs_video_frame->data[1] = pipeline->video_buffer + luma_size;
+	obs_video_frame->linesize[1] = width;
+}
 
-		//
-		// Change Tally
-		//
-		if (config_most_recent.tally.on_preview !=
-			    config_last_used.tally.on_preview ||
-		    config_most_recent.tally.on_program !=
-			    config_last_used.tally.on_program) {
-			config_last_used.tally = config_most_recent.tally;
+template<int sync_mode>
+static void ndi_source_pipeline_video(ndi_source_pipeline_t *pipeline,
+				      NDIlib_video_frame_v2_t *ndi_video_frame)
+{
+	auto obs_video_frame = &pipeline->video_template;
 
-			obs_log(LOG_INFO,
-				"'%s' ndi_source_thread: tally changed; Sending tally on_preview=%d, on_program=%d",
-				obs_source_name, //
-				config_most_recent.tally.on_preview,
-				config_most_recent.tally.on_program);
-			ndiLib->recv_set_tally(ndi_receiver,
-					       &config_most_recent.tally);
-		}
+	const bool odd_width = (ndi_video_frame->xres & 1) != 0;
+	if (ndi_video_frame->FourCC != pipeline->video_fourcc ||
+	    odd_width != pipeline->video_odd_width) {
+		ndi_source_pipeline_set_video_fourcc(
+			pipeline, ndi_video_frame->FourCC, odd_width);
+	}
 
-		if (ndi_frame_sync) {
-			//
-			// ndi_frame_sync
-			//
+	obs_video_frame->timestamp = ndi_frame_timestamp<sync_mode>(
+		ndi_video_frame->timestamp, ndi_video_frame->timecode);
+	obs_video_frame->width = ndi_video_frame->xres;
+	obs_video_frame->height = ndi_video_frame->yres;
 
-			//
-			// AUDIO
-			//
-			audio_frame2 = {};
-			ndiLib->framesync_capture_audio(
-				ndi_frame_sync, &audio_frame2,
-				0, // "Your desired sample rate. 0 for “use source”."
-				0, // "Your desired channel count. 0 for “use source”."
-				1024);
-			if (audio_frame2.p_data &&
-			    (audio_frame2.timestamp > timestamp_audio)) {
-				//blog(LOG_INFO, "a");//udio_frame");
-				timestamp_audio = audio_frame2.timestamp;
-				ndi_source_thread_process_audio2(
-					&config_most_recent, &audio_frame2,
-					s->obs_source, &obs_audio_frame);
-			}
-			ndiLib->framesync_free_audio(ndi_frame_sync,
-						     &audio_frame2);
+	ndi_video_planes_get(pipeline->video_planes, ndi_video_frame,
+			     obs_video_frame->data, obs_video_frame->linesize);
 
-			//
-			// VIDEO
-			//
-			video_frame2 = {};
-			ndiLib->framesync_capture_video(
-				ndi_frame_sync, &video_frame2,
-				NDIlib_frame_format_type_progressive);
-			if (video_frame2.p_data &&
-			    (video_frame2.timestamp > timestamp_video)) {
-				//blog(LOG_INFO, "v");//ideo_frame");
-				timestamp_video = video_frame2.timestamp;
-				ndi_source_thread_process_video2(
-					&config_most_recent, &video_frame2,
-					s->obs_source, &obs_video_frame);
-			}
-			ndiLib->framesync_free_video(ndi_frame_sync,
-						     &video_frame2);
+	if (pipeline->video_planes == NDI_VIDEO_PLANES_UYVY_TO_NV12)
+		ndi_source_repack_nv12(pipeline, ndi_video_frame);
+}
 
-			// TODO: More accurate sleep that subtracts the duration of this loop iteration?
-			std::this_thread::sleep_for(
-				std::chrono::milliseconds(5));
+template<int sync_mode>
+static void ndi_source_pipeline_select(ndi_source_pipeline_t *pipeline,
+				       bool audio_enabled, bool audio_rechunk)
+{
+	if (audio_enabled) {
+		// Framesync audio is already pulled in fixed size packets
+		pipeline->process_audio2 =
+			ndi_source_pipeline_audio<sync_mode,
+						  NDIlib_audio_frame_v2_t>;
+		if (audio_rechunk) {
+			pipeline->process_audio3 =
+				ndi_source_pipeline_audio_rechunk<sync_mode>;
 		} else {
-			//
-			// !ndi_frame_sync
-			//
-			frame_received = ndiLib->recv_capture_v3(ndi_receiver,
-								 &video_frame2,
-								 &audio_frame3,
-								 nullptr, 100);
-
-			if (frame_received == NDIlib_frame_type_audio) {
-				//
-				// AUDIO
-				//
-				//blog(LOG_INFO, "a");//udio_frame");
-				ndi_source_thread_process_audio3(
-					&config_most_recent, &audio_frame3,
-					s->obs_source, &obs_audio_frame);
-
-				ndiLib->recv_free_audio_v3(ndi_receiver,
-							   &audio_frame3);
-				continue;
-			}
-
-			if (frame_received == NDIlib_frame_type_video) {
-				//
-				// VIDEO
-				//
-				//blog(LOG_INFO, "v");//ideo_frame");
-				ndi_source_thread_process_video2(
-					&config_most_recent, &video_frame2,
-					s->obs_source, &obs_video_frame);
-
-				ndiLib->recv_free_video_v2(ndi_receiver,
-							   &video_frame2);
-				continue;
-			}
+			pipeline->process_audio3 = ndi_source_pipeline_audio<
+				sync_mode, NDIlib_audio_frame_v3_t>;
 		}
+	} else {
+		pipeline->process_audio2 = ndi_source_pipeline_audio_disabled<
+			NDIlib_audio_frame_v2_t>;
+		pipeline->process_audio3 = ndi_source_pipeline_audio_disabled<
+			NDIlib_audio_frame_v3_t>;
 	}
-	//
-	// Main NDI receiver loop: END
-	//
+	pipeline->prepare_video2 = ndi_source_pipeline_video<sync_mode>;
+}
 
-	if (ndi_frame_sync) {
-		ndiLib->framesync_destroy(ndi_frame_sync);
-		ndi_frame_sync = nullptr;
+static void ndi_source_pipeline_free(ndi_source_pipeline_t *pipeline,
+				     const char *obs_source_name)
+{
+	if (pipeline->audio_packets_out > 1) {
+		double intervals = (double)(pipeline->audio_packets_out - 1);
+		double mean = pipeline->audio_interval_sum / intervals;
+		double variance =
+			pipeline->audio_interval_sum_sq / intervals -
+			mean * mean;
+		obs_log(LOG_INFO,
+			"'%s' ndi_source_thread: audio%s: %llu NDI packets in, %llu OBS packets out; obs_source_output_audio avg=%.1fus max=%.1fus; interval avg=%.2fms jitter=%.2fms",
+			obs_source_name,
+			pipeline->audio_buffer ? " (re-chunked)" : "",
+			(unsigned long long)pipeline->audio_packets_in,
+			(unsigned long long)pipeline->audio_packets_out,
+			pipeline->audio_output_ns / 1000.0 /
+				(double)pipeline->audio_packets_out,
+			pipeline->audio_output_max_ns / 1000.0,
+			mean / 1000000.0,
+			sqrt(variance > 0.0 ? variance : 0.0) / 1000000.0);
 	}
+	bfree(pipeline->audio_buffer);
+	pipeline->audio_buffer = nullptr;
 
-	if (ndi_receiver) {
-		ndiLib->recv_destroy(ndi_receiver);
-		ndi_receiver = nullptr;
+	if (pipeline->video_repack_frames) {
+		obs_log(LOG_INFO,
+			"'%s' ndi_source_thread: video: %llu UYVY frames repacked to NV12, avg=%.1fus/frame; upload %.1fMB instead of %.1fMB",
+			obs_source_name,
+			(unsigned long long)pipeline->video_repack_frames,
+			pipeline->video_repack_ns / 1000.0 /
+				(double)pipeline->video_repack_frames,
+			pipeline->video_repack_bytes_out / 1000000.0,
+			pipeline->video_repack_bytes_in / 1000000.0);
 	}
-
-	obs_log(LOG_INFO, "'%s' -ndi_source_thread(…)", obs_source_name);
-
-	return nullptr;
+	bfree(pipeline->video_buffer);
+	pipeline->video_buffer = nullptr;
+	pipeline->video_buffer_size = 0;
+	stripe_pool_destroy(pipeline->video_stripe_pool);
+	pipeline->video_stripe_pool = nullptr;
 }
 
-void ndi_source_thread_process_audio2(ndi_source_config_t *config,
-				      NDIlib_audio_frame_v2_t *ndi_audio_frame2,
-				      obs_source_t *obs_source,
-				      obs_source_audio *obs_audio_frame)
+static void ndi_source_pipeline_init(ndi_source_pipeline_t *pipeline,
+				     const ndi_source_config_t *config)
 {
-	if (!config->audio_enabled) {
-		return;
+	*pipeline = {};
+
+	pipeline->audio_template.format = AUDIO_FORMAT_FLOAT_PLANAR;
+	if (config->audio_enabled && config->audio_rechunk) {
+		obs_audio_info oai;
+		pipeline->obs_sample_rate = obs_get_audio_info(&oai)
+						    ? oai.samples_per_sec
+						    : 48000;
+		pipeline->audio_buffer = (float *)bmalloc(
+			(size_t)MAX_AUDIO_CHANNELS * NDI_AUDIO_RECHUNK_FRAMES *
+			sizeof(float));
 	}
 
-	const int channelCount = ndi_audio_frame2->no_channels > 8
-					 ? 8
-					 : ndi_audio_frame2->no_channels;
+	pipeline->video_repack_nv12 = config->upload_format ==
+				      PROP_UPLOAD_FORMAT_NV12;
+	if (config->recv_pipelined && pipeline->video_repack_nv12) {
+		pipeline->video_stripe_pool = stripe_pool_create(
+			(size_t)std::min(os_get_physical_cores() / 2,
+					 NDI_VIDEO_STRIPE_MAX_WORKERS));
+	}
 
-	obs_audio_frame->speakers = channel_count_to_layout(channelCount);
+	video_format_get_parameters(config->yuv_colorspace, config->yuv_range,
+				    pipeline->video_template.color_matrix,
+				    pipeline->video_template.color_range_min,
+				    pipeline->video_template.color_range_max);
 
 	switch (config->sync_mode) {
 	case PROP_SYNC_NDI_TIMESTAMP:
-		obs_audio_frame->timestamp =
-			(uint64_t)(ndi_audio_frame2->timestamp * 100);
+		ndi_source_pipeline_select<PROP_SYNC_NDI_TIMESTAMP>(
+			pipeline, config->audio_enabled, config->audio_rechunk);
 		break;
 
 	case PROP_SYNC_NDI_SOURCE_TIMECODE:
-		obs_audio_frame->timestamp =
-			(uint64_t)(ndi_audio_frame2->timecode * 100);
+	default:
+		ndi_source_pipeline_select<PROP_SYNC_NDI_SOURCE_TIMECODE>(
+			pipeline, config->audio_enabled, config->audio_rechunk);
 		break;
 	}
-
-	obs_audio_frame->samples_per_sec = ndi_audio_frame2->sample_rate;
-	obs_audio_frame->format = AUDIO_FORMAT_FLOAT_PLANAR;
-	obs_audio_frame->frames = ndi_audio_frame2->no_samples;
-	for (int i = 0; i < channelCount; ++i) {
-		obs_audio_frame->data[i] =
-			(uint8_t *)ndi_audio_frame2->p_data +
-			(i * ndi_audio_frame2->channel_stride_in_bytes);
-	}
-
-	obs_source_output_audio(obs_source, obs_audio_frame);
 }
 
-void ndi_source_thread_process_audio3(ndi_source_config_t *config,
-				      NDIlib_audio_frame_v3_t *ndi_audio_frame3,
-				      obs_source_t *obs_source,
-				      obs_source_audio *obs_audio_frame)
+//
+// One receiver thread of the source, on the shared receive path (see
+// ndi-receiver.h). Everything here is owned by that thread.
+//
+typedef struct ndi_source_receiver_t {
+	ndi_source_t *s;
+	ndi_source_config_t config_most_recent;
+	ndi_source_config_t config_last_used;
+	// Both configs point at these copies, not at the source's strings
+	char *obs_source_name;
+	char *ndi_receiver_name;
+	char *ndi_source_name;
+
+	ndi_source_pipeline_t pipeline;
+	bool reset_pipeline;
+} ndi_source_receiver_t;
+
+/**
+ * Snapshots s->config for the receiver thread. The source frees its name
+ * strings whenever they are replaced, so the snapshot points at the
+ * thread's own copies instead.
+ */
+static void ndi_source_config_snapshot(ndi_source_receiver_t *r)
 {
-	if (!config->audio_enabled) {
-		return;
-	}
-
-	const int channelCount = ndi_audio_frame3->no_channels > 8
-					 ? 8
-					 : ndi_audio_frame3->no_channels;
-
-	obs_audio_frame->speakers = channel_count_to_layout(channelCount);
+	auto s = r->s;
+	auto config = &r->config_most_recent;
+	pthread_mutex_lock(&s->config_mutex);
+	*config = s->config;
+	ndi_source_copy_name(&r->obs_source_name, s->config.obs_source_name);
+	ndi_source_copy_name(&r->ndi_receiver_name,
+			     s->config.ndi_receiver_name);
+	ndi_source_copy_name(&r->ndi_source_name, s->config.ndi_source_name);
+	pthread_mutex_unlock(&s->config_mutex);
+	config->obs_source_name = r->obs_source_name;
+	config->ndi_receiver_name = r->ndi_receiver_name;
+	config->ndi_source_name = r->ndi_source_name;
+}
 
-	switch (config->sync_mode) {
-	case PROP_SYNC_NDI_TIMESTAMP:
-		obs_audio_frame->timestamp =
-			(uint64_t)(ndi_audio_frame3->timestamp * 100);
+static bool ndi_source_receiver_update(void *param,
+				       ndi_receiver_settings_t *settings)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	ndi_source_config_snapshot(r);
+	auto &config_most_recent = r->config_most_recent;
+	auto &config_last_used = r->config_last_used;
+
+	settings->name = config_most_recent.obs_source_name;
+	settings->ndi_receiver_name = config_most_recent.ndi_receiver_name;
+	settings->ndi_source_name = config_most_recent.ndi_source_name;
+	switch (config_most_recent.bandwidth) {
+	case PROP_BW_HIGHEST:
+	default:
+		settings->bandwidth = NDIlib_recv_bandwidth_highest;
 		break;
-
-	case PROP_SYNC_NDI_SOURCE_TIMECODE:
-		obs_audio_frame->timestamp =
-			(uint64_t)(ndi_audio_frame3->timecode * 100);
+	case PROP_BW_LOWEST:
+		settings->bandwidth = NDIlib_recv_bandwidth_lowest;
+		break;
+	case PROP_BW_AUDIO_ONLY:
+		settings->bandwidth = NDIlib_recv_bandwidth_audio_only;
 		break;
 	}
+	if (config_most_recent.latency == PROP_LATENCY_NORMAL)
+		settings->color_format = NDIlib_recv_color_format_UYVY_BGRA;
+	else
+		settings->color_format = NDIlib_recv_color_format_fastest;
+	settings->allow_video_fields = true;
+	settings->framesync = config_most_recent.framesync_enabled;
+	settings->pipelined = config_most_recent.recv_pipelined;
 
-	obs_audio_frame->samples_per_sec = ndi_audio_frame3->sample_rate;
-	obs_audio_frame->format = AUDIO_FORMAT_FLOAT_PLANAR;
-	obs_audio_frame->frames = ndi_audio_frame3->no_samples;
-	for (int i = 0; i < channelCount; ++i) {
-		obs_audio_frame->data[i] =
-			(uint8_t *)ndi_audio_frame3->p_data +
-			(i * ndi_audio_frame3->channel_stride_in_bytes);
+	//
+	// Re-select the receive pipeline if the way frames are handed to OBS changed
+	//
+	if (!r->reset_pipeline &&
+	    config_most_recent.sync_mode == config_last_used.sync_mode &&
+	    config_most_recent.yuv_range == config_last_used.yuv_range &&
+	    config_most_recent.yuv_colorspace ==
+		    config_last_used.yuv_colorspace &&
+	    config_most_recent.upload_format ==
+		    config_last_used.upload_format &&
+	    config_most_recent.recv_pipelined ==
+		    config_last_used.recv_pipelined &&
+	    config_most_recent.audio_enabled ==
+		    config_last_used.audio_enabled &&
+	    config_most_recent.audio_rechunk ==
+		    config_last_used.audio_rechunk) {
+		return false;
 	}
-
-	obs_source_output_audio(obs_source, obs_audio_frame);
+	r->reset_pipeline = false;
+	config_last_used.sync_mode = config_most_recent.sync_mode;
+	config_last_used.yuv_range = config_most_recent.yuv_range;
+	config_last_used.yuv_colorspace = config_most_recent.yuv_colorspace;
+	config_last_used.upload_format = config_most_recent.upload_format;
+	config_last_used.recv_pipelined = config_most_recent.recv_pipelined;
+	config_last_used.audio_enabled = config_most_recent.audio_enabled;
+	config_last_used.audio_rechunk = config_most_recent.audio_rechunk;
+	return true;
 }
 
-void ndi_source_thread_process_video2(ndi_source_config_t *config,
-				      NDIlib_video_frame_v2_t *ndi_video_frame,
-				      obs_source *obs_source,
-				      obs_source_frame *obs_video_frame)
+static void ndi_source_receiver_reconfigure(void *param)
 {
-	switch (ndi_video_frame->FourCC) {
-	case NDIlib_FourCC_type_BGRA:
-		obs_video_frame->format = VIDEO_FORMAT_BGRA;
-		break;
+	auto r = (ndi_source_receiver_t *)param;
+	// Pending re-chunked audio (less than a tick) is dropped
+	ndi_source_pipeline_free(&r->pipeline, r->obs_source_name);
+	ndi_source_pipeline_init(&r->pipeline, &r->config_most_recent);
+	obs_log(LOG_INFO,
+		"'%s' ndi_source_thread: pipeline changed; sync_mode=%d, audio %s",
+		r->obs_source_name, //
+		r->config_most_recent.sync_mode,
+		r->config_most_recent.audio_enabled ? "enabled" : "disabled");
+}
 
-	case NDIlib_FourCC_type_BGRX:
-		obs_video_frame->format = VIDEO_FORMAT_BGRX;
-		break;
+static void ndi_source_receiver_created(void *param)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	// Deactivate the source output video texture when using Audio only
+	if (r->config_most_recent.bandwidth == PROP_BW_AUDIO_ONLY) {
+		obs_log(LOG_INFO,
+			"'%s' ndi_source_thread: Audio Only: Deactivate source output video texture",
+			r->obs_source_name);
+		deactivate_source_output_video_texture(r->s->obs_source);
+	}
+}
 
-	case NDIlib_FourCC_type_RGBA:
-	case NDIlib_FourCC_type_RGBX:
-		obs_video_frame->format = VIDEO_FORMAT_RGBA;
-		break;
+static void ndi_source_receiver_connected(void *param,
+					  NDIlib_recv_instance_t ndi_receiver)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	auto obs_source_name = r->obs_source_name;
+	auto &config_most_recent = r->config_most_recent;
+	auto &config_last_used = r->config_last_used;
 
-	case NDIlib_FourCC_type_UYVY:
-	case NDIlib_FourCC_type_UYVA:
-		obs_video_frame->format = VIDEO_FORMAT_UYVY;
-		break;
+	//
+	// Change hardware acceleration
+	//
+	if (config_most_recent.hw_accel_enabled !=
+	    config_last_used.hw_accel_enabled) {
+		config_last_used.hw_accel_enabled =
+			config_most_recent.hw_accel_enabled;
 
-	case NDIlib_FourCC_type_I420:
-		obs_video_frame->format = VIDEO_FORMAT_I420;
-		break;
+		//
+		// From https://docs.ndi.video/docs/sdk/performance-and-implementation#receiving-video :
+		// > * In the modern versions of NDI, there are internal heuristics that attempt to guess whether hardware
+		// > acceleration would enable better performance. That said, it is possible to explicitly enable hardware
+		// > acceleration if you believe that it would be beneficial for your application. This can be enabled by
+		// > sending an XML metadata message to a receiver as follows:
+		// >	<ndi_video_codec type="hardware"/>
+		//
+		// The wording of this says very unambiguously "it is possible to explicitly enable hardware acceleration",
+		// but this can in reality only ever be a **REQUEST** to enable. The enable could fail, possibly for the
+		// obvious reason that the device may not have/support hardware acceleration.
+		//
+		// Furthermore, there is no documented way to request to *disable* hardware acceleration.
+		// I have tried setting the metadata to `<ndi_video_codec type=""/>` or `<ndi_video_codec/>` and it does not
+		// crash, but I was unable to confirm if this actually disabled hardware acceleration, and am skeptical that
+		// it could/would.
+		// So, it seems like there is no way to disable this.
+		// I have asked on the NewTek NDI SDK forum here:
+		// https://forum.vizrt.com/index.php?threads/any-way-to-explicitly-turn-off-hardware-acceleration.253766/
+		//
+		// Regardless, it makes little sense to have a checkbox that requests to enable this when
+		// checked but do nothing when unchecked.
+		// But that is what we are going to do here...
+		//
+		if (config_most_recent.hw_accel_enabled) {
+			NDIlib_metadata_frame_t hwAccelMetadata;
+			hwAccelMetadata.p_data =
+				(char *)"<ndi_video_codec type=\"hardware\"/>";
+			obs_log(LOG_INFO,
+				"ndi_source_thread: '%s' hw_accel_enabled changed to enabled; Sending NDI metadata '%s' to request hardware acceleration",
+				obs_source_name, hwAccelMetadata.p_data);
+			ndiLib->recv_send_metadata(ndi_receiver,
+						   &hwAccelMetadata);
+		}
+	}
 
-	case NDIlib_FourCC_type_NV12:
-		obs_video_frame->format = VIDEO_FORMAT_NV12;
-		break;
+	//
+	// Change PTZ
+	//
+	if (config_most_recent.ptz.enabled) {
+		const static float tollerance = 0.001f;
+		if (fabs(config_most_recent.ptz.pan -
+			 config_last_used.ptz.pan) > tollerance ||
+		    fabs(config_most_recent.ptz.tilt -
+			 config_last_used.ptz.tilt) > tollerance ||
+		    fabs(config_most_recent.ptz.zoom -
+			 config_last_used.ptz.zoom) > tollerance) {
+			if (ndiLib->recv_ptz_is_supported(ndi_receiver)) {
+				config_last_used.ptz = config_most_recent.ptz;
 
-	default:
-		obs_log(LOG_WARNING,
-			"warning: unsupported video pixel format: %d",
-			ndi_video_frame->FourCC);
-		break;
+				obs_log(LOG_INFO,
+					"'%s' ndi_source_thread: ptz changed; Sending PTZ pan=%f, tilt=%f, zoom=%f",
+					obs_source_name, //
+					config_most_recent.ptz.pan,
+					config_most_recent.ptz.tilt,
+					config_most_recent.ptz.zoom);
+				ndiLib->recv_ptz_pan_tilt(
+					ndi_receiver,
+					config_most_recent.ptz.pan,
+					config_most_recent.ptz.tilt);
+				ndiLib->recv_ptz_zoom(
+					ndi_receiver,
+					config_most_recent.ptz.zoom);
+			}
+		}
 	}
 
-	switch (config->sync_mode) {
-	case PROP_SYNC_NDI_TIMESTAMP:
-		obs_video_frame->timestamp =
-			(uint64_t)(ndi_video_frame->timestamp * 100);
-		break;
+	//
+	// Change Tally
+	//
+	if (config_most_recent.tally.on_preview !=
+		    config_last_used.tally.on_preview ||
+	    config_most_recent.tally.on_program !=
+		    config_last_used.tally.on_program) {
+		config_last_used.tally = config_most_recent.tally;
 
-	case PROP_SYNC_NDI_SOURCE_TIMECODE:
-		obs_video_frame->timestamp =
-			(uint64_t)(ndi_video_frame->timecode * 100);
-		break;
+		obs_log(LOG_INFO,
+			"'%s' ndi_source_thread: tally changed; Sending tally on_preview=%d, on_program=%d",
+			obs_source_name, //
+			config_most_recent.tally.on_preview,
+			config_most_recent.tally.on_program);
+		ndiLib->recv_set_tally(ndi_receiver,
+				       &config_most_recent.tally);
 	}
+}
 
-	obs_video_frame->width = ndi_video_frame->xres;
-	obs_video_frame->height = ndi_video_frame->yres;
-	obs_video_frame->linesize[0] = ndi_video_frame->line_stride_in_bytes;
-	obs_video_frame->data[0] = ndi_video_frame->p_data;
+static void ndi_source_receiver_video(void *param,
+				      NDIlib_video_frame_v2_t *ndi_video_frame)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	r->pipeline.prepare_video2(&r->pipeline, ndi_video_frame);
+	obs_source_output_video(r->s->obs_source, &r->pipeline.video_template);
+}
 
-	video_format_get_parameters(config->yuv_colorspace, config->yuv_range,
-				    obs_video_frame->color_matrix,
-				    obs_video_frame->color_range_min,
-				    obs_video_frame->color_range_max);
+static void ndi_source_receiver_audio(void *param,
+				      NDIlib_audio_frame_v3_t *ndi_audio_frame)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	r->pipeline.process_audio3(&r->pipeline, ndi_audio_frame,
+				   r->s->obs_source);
+}
+
+// Framesync audio
+static void ndi_source_receiver_audio2(void *param,
+				       NDIlib_audio_frame_v2_t *ndi_audio_frame)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	r->pipeline.process_audio2(&r->pipeline, ndi_audio_frame,
+				   r->s->obs_source);
+}
+
+static void ndi_source_receiver_destroy(void *param)
+{
+	auto r = (ndi_source_receiver_t *)param;
+	ndi_source_pipeline_free(&r->pipeline, r->obs_source_name);
+
+	obs_log(LOG_INFO, "'%s' -ndi_source_thread(…)", r->obs_source_name);
 
-	obs_source_output_video(obs_source, obs_video_frame);
+	bfree(r->obs_source_name);
+	bfree(r->ndi_receiver_name);
+	bfree(r->ndi_source_name);
+	ndi_source_release(r->s);
+	delete r;
 }
 
 void ndi_source_thread_start(ndi_source_t *s)
 {
+	auto obs_source_name = obs_source_get_name(s->obs_source);
+	obs_log(LOG_INFO, "'%s' +ndi_source_thread(…)", obs_source_name);
+
+	ndi_receiver_callbacks_t callbacks = {};
+	callbacks.update = ndi_source_receiver_update;
+	callbacks.reconfigure = ndi_source_receiver_reconfigure;
+	callbacks.created = ndi_source_receiver_created;
+	callbacks.connected = ndi_source_receiver_connected;
+	callbacks.video = ndi_source_receiver_video;
+	callbacks.audio = ndi_source_receiver_audio;
+	callbacks.audio2 = ndi_source_receiver_audio2;
+	callbacks.destroy = ndi_source_receiver_destroy;
+
+	// The configs' constructors must run, so not bzalloc
+	auto r = new ndi_source_receiver_t();
+	r->s = s;
+	r->reset_pipeline = true;
+	os_atomic_inc_long(&s->refs);
+	s->receiver = ndi_receiver_start(&callbacks, r);
+	if (!s->receiver) {
+		obs_log(LOG_ERROR,
+			"'%s' ndi_source_thread_start: ERROR: cannot create A/V ndi_source_thread",
+			obs_source_name);
+		ndi_source_release(s);
+		delete r;
+		s->running = false;
+		return;
+	}
 	s->running = true;
-	pthread_create(&s->av_thread, nullptr, ndi_source_thread, s);
 	obs_log(LOG_INFO,
 		"'%s' ndi_source_thread_start: Started A/V ndi_source_thread for NDI source '%s'",
-		obs_source_get_name(s->obs_source), s->config.ndi_source_name);
+		obs_source_name, s->config.ndi_source_name);
 }
 
 void ndi_source_thread_stop(ndi_source_t *s)
 {
 	if (s->running) {
 		s->running = false;
-		pthread_join(s->av_thread, NULL);
+		// Past this point the thread no longer touches obs_source; it
+		// only finishes its NDI calls and tears down its receiver.
+		ndi_receiver_stop(s->receiver);
+		s->receiver = nullptr;
 		auto obs_source = s->obs_source;
 		auto obs_source_name = obs_source_get_name(obs_source);
 		obs_log(LOG_INFO,
@@ -1038,7 +1376,12 @@ void ndi_source_update(void *data, obs_data_t *settings)
 	auto obs_source_name = obs_source_get_name(obs_source);
 	obs_log(LOG_INFO, "'%s' +ndi_source_update(…)", obs_source_name);
 
-	s->config.ndi_source_name = obs_data_get_string(settings, PROP_SOURCE);
+	// A/V threads only read the name through their own copies, taken
+	// under config_mutex
+	const char *ndi_source_name = obs_data_get_string(settings, PROP_SOURCE);
+	pthread_mutex_lock(&s->config_mutex);
+	ndi_source_copy_name(&s->config.ndi_source_name, ndi_source_name);
+	pthread_mutex_unlock(&s->config_mutex);
 	s->config.bandwidth = (int)obs_data_get_int(settings, PROP_BANDWIDTH);
 
 	const char *behavior = obs_data_get_string(settings, PROP_BEHAVIOR);
@@ -1086,6 +1429,8 @@ void ndi_source_update(void *data, obs_data_t *settings)
 		(int)obs_data_get_int(settings, PROP_YUV_RANGE));
 	s->config.yuv_colorspace = prop_to_colorspace(
 		(int)obs_data_get_int(settings, PROP_YUV_COLORSPACE));
+	s->config.upload_format =
+		(int)obs_data_get_int(settings, PROP_UPLOAD_FORMAT);
 
 	s->config.latency = (int)obs_data_get_int(settings, PROP_LATENCY);
 	// Disable OBS buffering only for "Lowest" latency mode
@@ -1093,6 +1438,10 @@ void ndi_source_update(void *data, obs_data_t *settings)
 	obs_source_set_async_unbuffered(obs_source, is_unbuffered);
 
 	s->config.audio_enabled = obs_data_get_bool(settings, PROP_AUDIO);
+	s->config.audio_rechunk =
+		obs_data_get_bool(settings, PROP_AUDIO_RECHUNK);
+	s->config.recv_pipelined =
+		obs_data_get_bool(settings, PROP_RECV_PIPELINED);
 	obs_source_set_audio_active(obs_source, s->config.audio_enabled);
 
 	bool ptz_enabled = obs_data_get_bool(settings, PROP_PTZ);
@@ -1101,6 +1450,19 @@ void ndi_source_update(void *data, obs_data_t *settings)
 	float zoom = (float)obs_data_get_double(settings, PROP_ZOOM);
 	s->config.ptz = ptz_t(ptz_enabled, pan, tilt, zoom);
 
+	if (obs_data_get_bool(settings, PROP_MIXMINUS)) {
+		const char *mixminus_name =
+			obs_data_get_string(settings, PROP_MIXMINUS_NAME);
+		mix_minus_set_guest(
+			obs_source,
+			strlen(mixminus_name) > 0
+				? mixminus_name
+				: QT_TO_UTF8(QString("%1 Mix-Minus")
+						     .arg(obs_source_name)));
+	} else {
+		mix_minus_remove_guest(obs_source);
+	}
+
 	// Update tally status
 	auto config = Config::Current();
 	s->config.tally.on_preview = config->TallyPreviewEnabled &&
@@ -1220,6 +1582,9 @@ void *ndi_source_create(obs_data_t *settings, obs_source_t *obs_source)
 
 	auto s = (ndi_source_t *)bzalloc(sizeof(ndi_source_t));
 	s->obs_source = obs_source;
+	s->refs = 1;
+	pthread_mutex_init(&s->config_mutex, nullptr);
+	ndi_source_copy_name(&s->config.obs_source_name, obs_source_name);
 	new_ndi_receiver_name(obs_source_name, &(s->config.ndi_receiver_name));
 
 	auto sh = obs_source_get_signal_handler(s->obs_source);
@@ -1236,7 +1601,10 @@ void ndi_source_renamed(void *data, calldata_t *)
 {
 	auto s = (ndi_source_t *)data;
 	auto obs_source_name = obs_source_get_name(s->obs_source);
+	pthread_mutex_lock(&s->config_mutex);
+	ndi_source_copy_name(&s->config.obs_source_name, obs_source_name);
 	new_ndi_receiver_name(obs_source_name, &(s->config.ndi_receiver_name));
+	pthread_mutex_unlock(&s->config_mutex);
 	obs_log(LOG_INFO, "'%s' ndi_source_renamed: ndi_receiver_name='%s'",
 		obs_source_name, s->config.ndi_receiver_name);
 }
@@ -1250,13 +1618,12 @@ void ndi_source_destroy(void *data)
 	signal_handler_disconnect(obs_source_get_signal_handler(s->obs_source),
 				  "rename", ndi_source_renamed, s);
 
+	mix_minus_remove_guest(s->obs_source);
+
 	ndi_source_thread_stop(s);
 
-	if (s->config.ndi_receiver_name) {
-		bfree(s->config.ndi_receiver_name);
-		s->config.ndi_receiver_name = nullptr;
-	}
-	bfree(s);
+	// The A/V thread, if still winding down, holds the last reference
+	ndi_source_release(s);
 
 	obs_log(LOG_INFO, "'%s' -ndi_source_destroy(…)", obs_source_name);
 }
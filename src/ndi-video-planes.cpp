@@ -0,0 +1,61 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "ndi-video-planes.h"
+
+void ndi_video_planes_get(enum ndi_video_planes planes,
+			  const NDIlib_video_frame_v2_t *frame,
+			  uint8_t *data[3], uint32_t linesize[3])
+{
+	const uint32_t stride = (uint32_t)frame->line_stride_in_bytes;
+	uint8_t *luma = frame->p_data;
+	uint8_t *chroma = luma + (size_t)stride * (uint32_t)frame->yres;
+
+	data[0] = luma;
+	linesize[0] = stride;
+	data[1] = nullptr;
+	linesize[1] = 0;
+	data[2] = nullptr;
+	linesize[2] = 0;
+
+	switch (planes) {
+	case NDI_VIDEO_PLANES_I420:
+	case NDI_VIDEO_PLANES_YV12: {
+		// Chroma planes are half width and half height
+		const uint32_t chroma_stride = stride / 2;
+		const uint32_t chroma_rows = ((uint32_t)frame->yres + 1) / 2;
+		uint8_t *second = chroma + (size_t)chroma_stride * chroma_rows;
+		// I420 is Y, U, V; YV12 is Y, V, U
+		const bool is_yv12 = planes == NDI_VIDEO_PLANES_YV12;
+		data[1] = is_yv12 ? second : chroma;
+		data[2] = is_yv12 ? chroma : second;
+		linesize[1] = chroma_stride;
+		linesize[2] = chroma_stride;
+		break;
+	}
+
+	case NDI_VIDEO_PLANES_NV12:
+		// Interleaved UV plane, half height, same stride as Y
+		data[1] = chroma;
+		linesize[1] = stride;
+		break;
+
+	case NDI_VIDEO_PLANES_PACKED:
+	case NDI_VIDEO_PLANES_UYVY_TO_NV12:
+		break;
+	}
+}
@@ -0,0 +1,47 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Processing.NDI.Lib.h>
+
+/**
+ * How the planes of a received NDI frame are handed to OBS.
+ */
+enum ndi_video_planes {
+	NDI_VIDEO_PLANES_PACKED,
+	NDI_VIDEO_PLANES_I420,
+	NDI_VIDEO_PLANES_YV12,
+	NDI_VIDEO_PLANES_NV12,
+	NDI_VIDEO_PLANES_UYVY_TO_NV12,
+};
+
+/**
+ * Derives the OBS plane pointers and line sizes of `frame`.
+ *
+ * NDI delivers planar formats as one contiguous buffer: the full resolution
+ * Y plane followed by the chroma plane(s), so the planes can be handed to
+ * OBS in place. I420 and YV12 come out in OBS's Y, U, V order. Unused planes
+ * are cleared. Frames that are repacked before output (UYVY to NV12) are
+ * described as their packed source.
+ */
+void ndi_video_planes_get(enum ndi_video_planes planes,
+			  const NDIlib_video_frame_v2_t *frame,
+			  uint8_t *data[3], uint32_t linesize[3]);
@@ -17,15 +17,22 @@
 
 #include "plugin-main.h"
 
+#include "async-log.h"
+#include "canvas-output.h"
 #include "forms/output-settings.h"
 #include "forms/update.h"
 #include "main-output.h"
+#include "mix-minus.h"
+#include "ndi-lib.h"
+#include "ndi-receiver.h"
 #include "preview-output.h"
 
+#include <util/platform.h>
+
 #include <QAction>
+#include <QCoreApplication>
 #include <QDir>
 #include <QFileInfo>
-#include <QLibrary>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QPointer>
@@ -45,11 +52,12 @@ const char *obs_module_description()
 	return Str("NDIPlugin.Description");
 }
 
-const NDIlib_v5 *ndiLib = nullptr;
-
 extern struct obs_source_info create_ndi_source_info();
 struct obs_source_info ndi_source_info;
 
+extern struct obs_source_info create_ndi_grid_source_info();
+struct obs_source_info ndi_grid_source_info;
+
 extern struct obs_output_info create_ndi_output_info();
 struct obs_output_info ndi_output_info;
 
@@ -64,8 +72,7 @@ struct obs_source_info alpha_filter_info;
 
 const NDIlib_v5 *load_ndilib();
 
-typedef const NDIlib_v5 *(*NDIlib_v5_load_)(void);
-QLibrary *loaded_lib = nullptr;
+ndi_lib_t *loaded_lib = nullptr;
 
 NDIlib_find_instance_t ndi_finder = nullptr;
 OutputSettings *output_settings = nullptr;
@@ -175,19 +182,109 @@ void showCriticalUnloadingMessageBoxDelayed(const QString &title,
 //
 //
 
+//
+// Startup probes are cached in the global config against the modification
+// times of the directories they scanned, so that warm starts on an unchanged
+// system skip the scans.
+//
+
+/**
+ * @param dirs The directories to stamp
+ * @return `;` separated list of `<path>|<mtime>` entries; missing directories have an mtime of 0
+ */
+QString probe_dirs_stamp(const QStringList &dirs)
+{
+	auto entries = QStringList();
+	for (const auto &dir : dirs) {
+		auto dir_info = QFileInfo(dir);
+		auto mtime = dir_info.exists()
+				     ? dir_info.lastModified().toMSecsSinceEpoch()
+				     : 0;
+		entries << QString("%1|%2").arg(dir).arg(mtime);
+	}
+	return entries.join(";");
+}
+
+/**
+ * @param stamp A stamp previously returned by `probe_dirs_stamp`
+ * @return true if the stamp is not empty and none of its directories changed since it was taken
+ */
+bool probe_dirs_unchanged(const QString &stamp)
+{
+	if (stamp.isEmpty() || Config::ProbeCacheIgnore) {
+		return false;
+	}
+	auto dirs = QStringList();
+	for (const auto &entry : stamp.split(";", Qt::SkipEmptyParts)) {
+		dirs << entry.section("|", 0, -2);
+	}
+	return probe_dirs_stamp(dirs) == stamp;
+}
+
+/**
+ * Logs the time elapsed since `start_ns` for a named `obs_module_load` phase.
+ * @return The current time, to be used as the start of the next phase
+ */
+uint64_t log_load_phase(const char *phase, uint64_t start_ns)
+{
+	auto now_ns = os_gettime_ns();
+	obs_log(LOG_INFO, "obs_module_load: phase '%s' took %.3f ms", phase,
+		(double)(now_ns - start_ns) / 1000000.0);
+	return now_ns;
+}
+
+//
+//
+//
+
 struct find_module_data {
 	const char *target_name;
 	bool found;
+	QStringList dirs;
 };
 
-bool is_module_found(const char *module_name)
+/**
+ * @return The directories that must change if a module is added to or removed
+ * from the same location as `bin_path`: the directory holding the binary and,
+ * for per-plugin layouts (`<name>/bin/64bit/`, `<name>.plugin/Contents/MacOS/`),
+ * the directory holding the plugin folder.
+ */
+QStringList module_dirs(const char *name, const char *bin_path)
+{
+	auto dirs = QStringList();
+	auto dir = QDir(QFileInfo(QString::fromUtf8(bin_path)).absolutePath());
+	dirs << dir.absolutePath();
+	auto module_name = QString::fromUtf8(name);
+	do {
+		auto dir_name = dir.dirName();
+		if (dir_name == module_name ||
+		    dir_name.startsWith(module_name + ".")) {
+			if (dir.cdUp()) {
+				dirs << dir.absolutePath();
+			}
+			break;
+		}
+	} while (dir.cdUp());
+	return dirs;
+}
+
+bool is_module_found(const char *module_name, QStringList *dirs = nullptr)
 {
-	struct find_module_data data = {0};
+	struct find_module_data data = {};
 	data.target_name = module_name;
 	obs_find_modules2(
 		[](void *param, const struct obs_module_info2 *module_info) {
 			struct find_module_data *data_ =
 				(struct find_module_data *)param;
+			if (module_info->bin_path) {
+				for (const auto &dir :
+				     module_dirs(module_info->name,
+						 module_info->bin_path)) {
+					if (!data_->dirs.contains(dir)) {
+						data_->dirs << dir;
+					}
+				}
+			}
 			if (strcmp(data_->target_name, module_info->name) ==
 			    0) {
 				obs_log(LOG_INFO,
@@ -205,24 +302,91 @@ bool is_module_found(const char *module_name)
 			}
 		},
 		&data);
+	if (dirs) {
+		*dirs = data.dirs;
+	}
 	return data.found;
 }
 
+/**
+ * @return Every directory OBS searches for modules, whether or not it exists
+ * or holds any module yet, so that installing into an empty or new location
+ * still changes the probe stamp.
+ */
+QStringList module_search_dirs()
+{
+	auto dirs = QStringList();
+	auto bin_path = obs_get_module_binary_path(obs_current_module());
+	if (bin_path) {
+		dirs << module_dirs(PLUGIN_NAME, bin_path);
+	}
+
+	auto app_dir = QCoreApplication::applicationDirPath();
+#if defined(Q_OS_WIN)
+	dirs << QDir::cleanPath(app_dir + "/../../obs-plugins/64bit");
+#elif defined(Q_OS_MACOS)
+	dirs << QDir::cleanPath(app_dir + "/../PlugIns");
+#else
+	dirs << QDir::cleanPath(app_dir + "/../lib/obs-plugins");
+#endif
+
+	auto user_plugins = os_get_config_path_ptr("obs-studio/plugins");
+	if (user_plugins) {
+		dirs << QDir::cleanPath(QString::fromUtf8(user_plugins));
+		bfree(user_plugins);
+	}
+	return dirs;
+}
+
 bool is_obsndi_installed()
 {
 	auto force = Config::DetectObsNdiForce;
 	if (force != 0) {
 		return force > 0;
 	}
-	return is_module_found("obs-ndi");
+
+	auto config = Config::Current(false);
+	if (probe_dirs_unchanged(config->ProbeObsNdiDirs())) {
+		auto found = config->ProbeObsNdiFound();
+		obs_log(LOG_INFO,
+			"is_obsndi_installed: Module directories unchanged; using cached result found=%d",
+			found);
+		return found;
+	}
+
+	auto dirs = QStringList();
+	auto found = is_module_found("obs-ndi", &dirs);
+	for (const auto &dir : module_search_dirs()) {
+		if (!dirs.contains(dir)) {
+			dirs << dir;
+		}
+	}
+	config->ProbeObsNdi(probe_dirs_stamp(dirs), found);
+	return found;
 }
 
 //
 //
 //
 
+/**
+ * Logs messages from the NDI core (see core/ndi-core.h) like the rest of the
+ * plugin; its log levels are libobs' own.
+ */
+static void plugin_core_log(int log_level, const char *format, va_list args)
+{
+	char message[4096];
+	vsnprintf(message, sizeof(message), format, args);
+	obs_log(log_level, "%s", message);
+}
+
 bool obs_module_load(void)
 {
+	auto load_start_ns = os_gettime_ns();
+	auto phase_start_ns = load_start_ns;
+
+	ndi_core_set_log_handler(plugin_core_log);
+
 	obs_log(LOG_INFO, "obs_module_load: you can haz %s (Version %s)",
 		PLUGIN_DISPLAY_NAME, PLUGIN_VERSION);
 	obs_log(LOG_INFO,
@@ -231,8 +395,11 @@ bool obs_module_load(void)
 
 	// TODO:(pv) Clean up this call in the near future...
 	Config::Current();
+	phase_start_ns = log_load_phase("config", phase_start_ns);
 
-	if (is_obsndi_installed()) {
+	auto obsndi_installed = is_obsndi_installed();
+	phase_start_ns = log_load_phase("detect obs-ndi", phase_start_ns);
+	if (obsndi_installed) {
 		obs_log(LOG_INFO,
 			"obs_module_load: OBS-NDI is detected and needs to be uninstalled before %s will load.",
 			PLUGIN_DISPLAY_NAME);
@@ -253,6 +420,7 @@ bool obs_module_load(void)
 #else
 	ndiLib = load_ndilib();
 #endif
+	phase_start_ns = log_load_phase("load_ndilib", phase_start_ns);
 	if (!ndiLib) {
 		auto title = Str("NDIPlugin.LibError.Title");
 		auto message = QTStr("NDIPlugin.LibError.Message") + "<br>";
@@ -274,24 +442,35 @@ bool obs_module_load(void)
 #else
 	auto initialized = ndiLib->initialize();
 #endif
+	phase_start_ns = log_load_phase("ndiLib->initialize", phase_start_ns);
 	if (!initialized) {
 		obs_log(LOG_ERROR,
 			"obs_module_load: ndiLib->initialize() failed; CPU unsupported by NDI library. Module won't load.");
 		return false;
 	}
 
+	auto ndi_version = QString::fromUtf8(ndiLib->version());
 	obs_log(LOG_INFO,
 		"obs_module_load: NDI library initialized successfully ('%s')",
-		ndiLib->version());
+		QT_TO_UTF8(ndi_version));
+	auto config = Config::Current(false);
+	if (config->ProbeNdiLibVersion() != ndi_version) {
+		config->ProbeNdiLibVersion(ndi_version);
+	}
 
 	NDIlib_find_create_t find_desc = {0};
 	find_desc.show_local_sources = true;
 	find_desc.p_groups = NULL;
 	ndi_finder = ndiLib->find_create_v2(&find_desc);
+	phase_start_ns = log_load_phase("ndiLib->find_create_v2",
+					phase_start_ns);
 
 	ndi_source_info = create_ndi_source_info();
 	obs_register_source(&ndi_source_info);
 
+	ndi_grid_source_info = create_ndi_grid_source_info();
+	obs_register_source(&ndi_grid_source_info);
+
 	ndi_output_info = create_ndi_output_info();
 	obs_register_output(&ndi_output_info);
 
@@ -303,6 +482,7 @@ bool obs_module_load(void)
 
 	alpha_filter_info = create_alpha_filter_info();
 	obs_register_source(&alpha_filter_info);
+	phase_start_ns = log_load_phase("register", phase_start_ns);
 
 	if (main_window) {
 		auto menu_action = static_cast<QAction *>(
@@ -324,15 +504,31 @@ bool obs_module_load(void)
 				    OBS_FRONTEND_EVENT_FINISHED_LOADING) {
 					main_output_init();
 					preview_output_init();
+					canvas_output_init();
+				} else if (event ==
+					   OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING) {
+					// The canvas view holds a reference to a scene of the old collection
+					canvas_output_deinit();
+				} else if (event ==
+					   OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED) {
+					canvas_output_init();
 				} else if (event == OBS_FRONTEND_EVENT_EXIT) {
 					// Unknown why putting this in obs_module_unload causes a crash when closing OBS
 					main_output_deinit();
 					preview_output_deinit();
+					canvas_output_deinit();
+					mix_minus_deinit();
 				}
 			},
 			nullptr);
+		phase_start_ns = log_load_phase("ui", phase_start_ns);
 	}
 
+	log_load_phase("total", load_start_ns);
+
+	// Sources, outputs and filters only log from their own threads from here on
+	async_log_init();
+
 	return true;
 }
 
@@ -351,6 +547,8 @@ void obs_module_unload(void)
 
 	updateCheckStop();
 
+	ndi_receiver_reaper_flush();
+
 	if (ndiLib) {
 		if (ndi_finder) {
 			ndiLib->find_destroy(ndi_finder);
@@ -360,93 +558,50 @@ void obs_module_unload(void)
 		ndiLib = nullptr;
 	}
 
-	if (loaded_lib) {
-		delete loaded_lib;
-	}
+	ndi_lib_unload(loaded_lib);
+	loaded_lib = nullptr;
 
 	obs_log(LOG_INFO, "-obs_module_unload(): goodbye!");
+
+	async_log_deinit();
 }
 
 const NDIlib_v5 *load_ndilib()
 {
-	auto locations = QStringList();
-	auto temp_path = QString(qgetenv(NDILIB_REDIST_FOLDER));
-	if (!temp_path.isEmpty()) {
-		locations << temp_path;
-	}
-#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
-	// Linux, MacOS
-	// https://github.com/DistroAV/DistroAV/blob/master/lib/ndi/NDI%20SDK%20Documentation.pdf
-	// "6.1 LOCATING THE LIBRARY
-	// ... the redistributable on MacOS is installed within `/usr/local/lib` ..."
-	locations << "/usr/lib";
-	locations << "/usr/local/lib";
-#endif
-	auto lib_path = QString();
-#if defined(Q_OS_LINUX)
-	// Linux
-	auto regex = QRegularExpression("libndi\\.so\\.(\\d+)");
-	int max_version = 0;
-#endif
+	auto locations = ndi_lib_locations();
+	auto locations_dirs = QStringList();
 	for (const auto &location : locations) {
-		auto dir = QDir(location);
-#if defined(Q_OS_LINUX)
-		// Linux
-		auto filters = QStringList("libndi.so.*");
-		dir.setNameFilters(filters);
-		auto file_names = dir.entryList(QDir::Files);
-		for (const auto &file_name : file_names) {
-			auto match = regex.match(file_name);
-			if (match.hasMatch()) {
-				int version = match.captured(1).toInt();
-				if (version > max_version) {
-					max_version = version;
-					lib_path =
-						dir.absoluteFilePath(file_name);
-				}
-			}
-		}
-#else
-		// MacOS, Windows
-		temp_path = QDir::cleanPath(
-			dir.absoluteFilePath(NDILIB_LIBRARY_NAME));
-		obs_log(LOG_INFO, "load_ndilib: Trying '%s'",
-			QT_TO_UTF8(QDir::toNativeSeparators(temp_path)));
-		auto file_info = QFileInfo(temp_path);
-		if (file_info.exists() && file_info.isFile()) {
-			lib_path = temp_path;
-			break;
-		}
-#endif
+		locations_dirs << QString::fromStdString(location);
 	}
-	if (!lib_path.isEmpty()) {
+	auto config = Config::Current(false);
+	auto locations_stamp = probe_dirs_stamp(locations_dirs);
+	auto lib_path = config->ProbeNdiLibPath();
+	auto is_cached = !lib_path.isEmpty() && !Config::ProbeCacheIgnore &&
+			 config->ProbeNdiLibDirs() == locations_stamp &&
+			 QFileInfo(lib_path).isFile();
+	if (is_cached) {
 		obs_log(LOG_INFO,
-			"load_ndilib: Found '%s'; attempting to load NDI library...",
-			QT_TO_UTF8(QDir::toNativeSeparators(lib_path)));
-		loaded_lib = new QLibrary(lib_path, nullptr);
-		if (loaded_lib->load()) {
-			obs_log(LOG_INFO,
-				"load_ndilib: NDI library loaded successfully");
-			NDIlib_v5_load_ lib_load =
-				reinterpret_cast<NDIlib_v5_load_>(
-					loaded_lib->resolve("NDIlib_v5_load"));
-			if (lib_load != nullptr) {
-				obs_log(LOG_INFO,
-					"load_ndilib: NDIlib_v5_load found");
-				return lib_load();
-			} else {
-				obs_log(LOG_ERROR,
-					"load_ndilib: ERROR: NDIlib_v5_load not found in loaded library");
+			"load_ndilib: Library locations unchanged; using cached '%s' (last loaded version '%s')",
+			QT_TO_UTF8(QDir::toNativeSeparators(lib_path)),
+			QT_TO_UTF8(config->ProbeNdiLibVersion()));
+	} else {
+		lib_path = QString::fromStdString(ndi_lib_find(locations));
+	}
+	if (!lib_path.isEmpty()) {
+		auto lib = ndi_lib_load(lib_path.toStdString(), &loaded_lib);
+		if (lib) {
+			if (!is_cached) {
+				config->ProbeNdiLib(locations_stamp, lib_path);
 			}
-		} else {
-			obs_log(LOG_ERROR,
-				"load_ndilib: ERROR: QLibrary returned the following error: '%s'",
-				QT_TO_UTF8(loaded_lib->errorString()));
-			delete loaded_lib;
-			loaded_lib = nullptr;
+			return lib;
 		}
 	}
 
+	// Never reuse a cached path that failed to load
+	if (!config->ProbeNdiLibPath().isEmpty()) {
+		config->ProbeNdiLib(QString(), QString());
+	}
+
 	obs_log(LOG_ERROR, "load_ndilib: ERROR: Can't find the NDI library");
 	return nullptr;
 }
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "config.h"
+#include "ndi-core.h"
 #include "obs-support/qt_wrapper.hpp"
 #include "plugin-support.h"
 
@@ -30,8 +31,6 @@
 
 #define OBS_NDI_ALPHA_FILTER_ID "premultiplied_alpha_filter"
 
-extern const NDIlib_v5 *ndiLib;
-
 /*
 The following accomplishes two goals:
 1. Enable the use of a local emulator at 127.0.0.1 for [non-production] testing Update
@@ -37,6 +37,14 @@ extern const char *PLUGIN_VERSION;
 
 void obs_log(int log_level, const char *format, ...);
 
+/**
+ * Replaces the synchronous `blogva` call in `obs_log`; NULL restores it.
+ * The handler receives the caller's format without the plugin prefix.
+ */
+typedef void (*obs_log_handler_t)(int log_level, const char *format,
+				  va_list args);
+void obs_log_set_handler(obs_log_handler_t handler);
+
 #ifdef __cplusplus
 }
 #endif
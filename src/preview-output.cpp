@@ -26,6 +26,7 @@ struct preview_output {
 	bool is_running;
 	QString ndi_name;
 	QString ndi_groups;
+	bool uyva_enabled;
 
 	obs_source_t *current_source;
 	obs_output_t *output;
@@ -168,6 +169,8 @@ void preview_output_start()
 		obs_data_set_string(settings, "ndi_name", output_name);
 		obs_data_set_string(settings, "ndi_groups",
 				    context.ndi_groups.toUtf8().constData());
+		obs_data_set_bool(settings, "uyva_enabled",
+				  context.uyva_enabled);
 		obs_output_update(context.output, settings);
 		obs_data_release(settings);
 
@@ -218,6 +221,7 @@ void preview_output_deinit()
 		context.output = nullptr;
 		context.ndi_name.clear();
 		context.ndi_groups.clear();
+		context.uyva_enabled = false;
 		obs_log(LOG_INFO,
 			"preview_output_deinit: successfully released NDI preview output '%s'",
 			output_name);
@@ -237,10 +241,12 @@ void preview_output_init()
 	auto output_name = config->PreviewOutputName;
 	auto output_groups = config->PreviewOutputGroups;
 	auto is_enabled = config->PreviewOutputEnabled;
+	auto uyva_enabled = config->PreviewOutputUYVA;
 
 	if (output_name.isEmpty() || //
 	    (output_name != context.ndi_name) ||
-	    output_groups != context.ndi_groups) {
+	    output_groups != context.ndi_groups ||
+	    uyva_enabled != context.uyva_enabled) {
 		preview_output_deinit();
 
 		if (!output_name.isEmpty()) {
@@ -253,6 +259,8 @@ void preview_output_init()
 					    output_name_);
 			obs_data_set_string(output_settings, "ndi_groups",
 					    output_groups.toUtf8().constData());
+			obs_data_set_bool(output_settings, "uyva_enabled",
+					  uyva_enabled);
 			obs_data_set_bool(output_settings, "uses_audio",
 					  false); // Preview has no audio
 			context.output = obs_output_create("ndi_output",
@@ -277,6 +285,7 @@ void preview_output_init()
 
 				context.ndi_name = output_name;
 				context.ndi_groups = output_groups;
+				context.uyva_enabled = uyva_enabled;
 			} else {
 				obs_log(LOG_ERROR,
 					"preview_output_init: failed to create NDI preview output '%s'",
@@ -0,0 +1,145 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "stripe-pool.h"
+
+#include <util/platform.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct stripe_pool_t {
+	std::vector<std::thread> threads;
+
+	// Stripes are claimed under the mutex: there are only a few per frame
+	std::mutex mutex;
+	std::condition_variable work_cv;
+	std::condition_variable done_cv;
+	bool stopping = false;
+
+	void (*fn)(void *param, uint32_t start_y, uint32_t end_y) = nullptr;
+	void *param = nullptr;
+	uint32_t rows = 0;
+	uint32_t stripe_rows = 0;
+	uint32_t stripes = 0;
+	uint32_t next_stripe = 0;
+	uint32_t stripes_done = 0;
+};
+
+/**
+ * Runs stripes of the current job until none are left to claim.
+ * Called, and returns, with the mutex held.
+ */
+static void stripe_pool_work(stripe_pool_t *pool,
+			     std::unique_lock<std::mutex> &lock)
+{
+	while (pool->next_stripe < pool->stripes) {
+		auto fn = pool->fn;
+		auto param = pool->param;
+		uint32_t start_y = pool->next_stripe++ * pool->stripe_rows;
+		uint32_t end_y = std::min(start_y + pool->stripe_rows,
+					  pool->rows);
+
+		lock.unlock();
+		fn(param, start_y, end_y);
+		lock.lock();
+
+		if (++pool->stripes_done == pool->stripes) {
+			pool->done_cv.notify_one();
+		}
+	}
+}
+
+static void stripe_pool_thread(stripe_pool_t *pool)
+{
+	os_set_thread_name("distroav: stripe worker");
+
+	std::unique_lock<std::mutex> lock(pool->mutex);
+	for (;;) {
+		pool->work_cv.wait(lock, [pool] {
+			return pool->stopping ||
+			       pool->next_stripe < pool->stripes;
+		});
+		if (pool->stopping) {
+			return;
+		}
+		stripe_pool_work(pool, lock);
+	}
+}
+
+stripe_pool_t *stripe_pool_create(size_t workers)
+{
+	if (!workers) {
+		return nullptr;
+	}
+
+	auto pool = new stripe_pool_t();
+	for (size_t i = 0; i < workers; ++i) {
+		pool->threads.emplace_back(stripe_pool_thread, pool);
+	}
+	return pool;
+}
+
+void stripe_pool_destroy(stripe_pool_t *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool->mutex);
+		pool->stopping = true;
+	}
+	pool->work_cv.notify_all();
+	for (auto &thread : pool->threads) {
+		thread.join();
+	}
+	delete pool;
+}
+
+void stripe_pool_run(stripe_pool_t *pool, uint32_t rows, uint32_t row_align,
+		     void (*fn)(void *param, uint32_t start_y, uint32_t end_y),
+		     void *param)
+{
+	// A few stripes per thread, so that one slow stripe does not hold up
+	// the whole frame
+	const uint32_t stripes_wanted =
+		(uint32_t)(pool->threads.size() + 1) * 2;
+	uint32_t stripe_rows = (rows + stripes_wanted - 1) / stripes_wanted;
+	stripe_rows = (stripe_rows + row_align - 1) / row_align * row_align;
+	if (!stripe_rows) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(pool->mutex);
+	pool->fn = fn;
+	pool->param = param;
+	pool->rows = rows;
+	pool->stripe_rows = stripe_rows;
+	pool->stripes = (rows + stripe_rows - 1) / stripe_rows;
+	pool->next_stripe = 0;
+	pool->stripes_done = 0;
+	pool->work_cv.notify_all();
+
+	stripe_pool_work(pool, lock);
+	pool->done_cv.wait(lock, [pool] {
+		return pool->stripes_done == pool->stripes;
+	});
+}
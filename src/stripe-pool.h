@@ -0,0 +1,41 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Worker threads that split row-independent work on one large frame into
+ * horizontal stripes. The calling thread works on stripes too.
+ */
+typedef struct stripe_pool_t stripe_pool_t;
+
+/**
+ * @param workers threads in addition to the caller; 0 returns nullptr
+ */
+stripe_pool_t *stripe_pool_create(size_t workers);
+void stripe_pool_destroy(stripe_pool_t *pool);
+
+/**
+ * Calls `fn` on stripes covering rows [0, rows) and returns once all are done.
+ * Stripe boundaries are multiples of `row_align`.
+ */
+void stripe_pool_run(stripe_pool_t *pool, uint32_t rows, uint32_t row_align,
+		     void (*fn)(void *param, uint32_t start_y, uint32_t end_y),
+		     void *param);
@@ -0,0 +1,591 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "video-conv.h"
+
+#include <util/bmem.h>
+
+#include <string.h>
+
+// SSE2 on x86, SIMDe translation on other architectures
+#include <util/sse-intrin.h>
+
+#define COEF_SHIFT 14
+
+static inline int16_t to_fixed(double value)
+{
+	return (int16_t)(value * (1 << COEF_SHIFT) + (value < 0 ? -0.5 : 0.5));
+}
+
+static inline uint8_t clamp_u8(int32_t value)
+{
+	return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+bool rgb_to_yuv_matrix_init(rgb_to_yuv_matrix_t *matrix, video_format format,
+			    video_colorspace colorspace, video_range_type range)
+{
+	int r_index;
+	int b_index;
+	switch (format) {
+	case VIDEO_FORMAT_RGBA:
+		r_index = 0;
+		b_index = 2;
+		break;
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+		r_index = 2;
+		b_index = 0;
+		break;
+	default:
+		return false;
+	}
+
+	double kr;
+	double kb;
+	switch (colorspace) {
+	case VIDEO_CS_601:
+		kr = 0.299;
+		kb = 0.114;
+		break;
+	case VIDEO_CS_2100_PQ:
+	case VIDEO_CS_2100_HLG:
+		kr = 0.2627;
+		kb = 0.0593;
+		break;
+	case VIDEO_CS_DEFAULT:
+	case VIDEO_CS_709:
+	case VIDEO_CS_SRGB:
+	default:
+		kr = 0.2126;
+		kb = 0.0722;
+		break;
+	}
+	double kg = 1.0 - kr - kb;
+
+	double y_scale = 1.0;
+	double c_scale = 1.0;
+	matrix->y_offset = 0;
+	if (range != VIDEO_RANGE_FULL) {
+		y_scale = 219.0 / 255.0;
+		c_scale = 224.0 / 255.0;
+		matrix->y_offset = 16;
+	}
+	matrix->c_offset = 128;
+
+	double y[3] = {};
+	double u[3] = {};
+	double v[3] = {};
+	y[0] = kr * y_scale;
+	y[1] = kg * y_scale;
+	y[2] = kb * y_scale;
+	u[0] = -kr / (2.0 * (1.0 - kb)) * c_scale;
+	u[1] = -kg / (2.0 * (1.0 - kb)) * c_scale;
+	u[2] = 0.5 * c_scale;
+	v[0] = 0.5 * c_scale;
+	v[1] = -kg / (2.0 * (1.0 - kr)) * c_scale;
+	v[2] = -kb / (2.0 * (1.0 - kr)) * c_scale;
+
+	for (int pixel = 0; pixel < 2; ++pixel) {
+		int16_t *y_row = matrix->y + pixel * 4;
+		int16_t *u_row = matrix->u + pixel * 4;
+		int16_t *v_row = matrix->v + pixel * 4;
+		y_row[r_index] = to_fixed(y[0]);
+		y_row[1] = to_fixed(y[1]);
+		y_row[b_index] = to_fixed(y[2]);
+		y_row[3] = 0;
+		u_row[r_index] = to_fixed(u[0]);
+		u_row[1] = to_fixed(u[1]);
+		u_row[b_index] = to_fixed(u[2]);
+		u_row[3] = 0;
+		v_row[r_index] = to_fixed(v[0]);
+		v_row[1] = to_fixed(v[1]);
+		v_row[b_index] = to_fixed(v[2]);
+		v_row[3] = 0;
+	}
+
+	return true;
+}
+
+static inline int32_t dot_pixel(const int16_t *coef, const uint8_t *pixel)
+{
+	return coef[0] * pixel[0] + coef[1] * pixel[1] + coef[2] * pixel[2];
+}
+
+/**
+ * 4 pixels of 32 bits in, 4 dot products out.
+ * `_mm_madd_epi16` yields 2 partial sums per pixel, which are then added.
+ */
+static inline __m128i dot_4_pixels(__m128i lo, __m128i hi, __m128i coef)
+{
+	__m128 a = _mm_castsi128_ps(_mm_madd_epi16(lo, coef));
+	__m128 b = _mm_castsi128_ps(_mm_madd_epi16(hi, coef));
+	__m128i even = _mm_castps_si128(
+		_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+	__m128i odd = _mm_castps_si128(
+		_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	return _mm_add_epi32(even, odd);
+}
+
+/**
+ * Adds horizontally adjacent pairs of 2 vectors of 4:
+ * [a0+a1, a2+a3, b0+b1, b2+b3]
+ */
+static inline __m128i sum_pairs(__m128i a, __m128i b)
+{
+	__m128 fa = _mm_castsi128_ps(a);
+	__m128 fb = _mm_castsi128_ps(b);
+	__m128i even = _mm_castps_si128(
+		_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+	__m128i odd = _mm_castps_si128(
+		_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+	return _mm_add_epi32(even, odd);
+}
+
+void convert_rgba_to_uyva(const rgb_to_yuv_matrix_t *matrix,
+			  const uint8_t *input, uint32_t in_linesize,
+			  uint32_t width, uint32_t start_y, uint32_t end_y,
+			  uint8_t *output, uint32_t out_linesize,
+			  uint8_t *alpha, uint32_t alpha_linesize)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i coef_y = _mm_loadu_si128((const __m128i *)matrix->y);
+	const __m128i coef_u = _mm_loadu_si128((const __m128i *)matrix->u);
+	const __m128i coef_v = _mm_loadu_si128((const __m128i *)matrix->v);
+	// Luma is rounded per pixel; chroma is the rounded average of 2 pixels
+	const int32_t y_bias = (matrix->y_offset << COEF_SHIFT) +
+			       (1 << (COEF_SHIFT - 1));
+	const int32_t c_bias = (matrix->c_offset << (COEF_SHIFT + 1)) +
+			       (1 << COEF_SHIFT);
+	const __m128i y_bias_v = _mm_set1_epi32(y_bias);
+	const __m128i c_bias_v = _mm_set1_epi32(c_bias);
+
+	const uint32_t simd_width = width & ~7u;
+
+	for (uint32_t row = start_y; row < end_y; ++row) {
+		const uint8_t *in = input + (size_t)row * in_linesize;
+		uint8_t *out = output + (size_t)row * out_linesize;
+		uint8_t *out_alpha = alpha + (size_t)row * alpha_linesize;
+
+		uint32_t x = 0;
+		for (; x < simd_width; x += 8) {
+			__m128i p0 = _mm_loadu_si128(
+				(const __m128i *)(in + (size_t)x * 4));
+			__m128i p1 = _mm_loadu_si128(
+				(const __m128i *)(in + (size_t)x * 4 + 16));
+
+			__m128i p0_lo = _mm_unpacklo_epi8(p0, zero);
+			__m128i p0_hi = _mm_unpackhi_epi8(p0, zero);
+			__m128i p1_lo = _mm_unpacklo_epi8(p1, zero);
+			__m128i p1_hi = _mm_unpackhi_epi8(p1, zero);
+
+			__m128i y0 = _mm_srai_epi32(
+				_mm_add_epi32(dot_4_pixels(p0_lo, p0_hi,
+							   coef_y),
+					      y_bias_v),
+				COEF_SHIFT);
+			__m128i y1 = _mm_srai_epi32(
+				_mm_add_epi32(dot_4_pixels(p1_lo, p1_hi,
+							   coef_y),
+					      y_bias_v),
+				COEF_SHIFT);
+			__m128i y16 = _mm_packs_epi32(y0, y1);
+
+			__m128i u = _mm_srai_epi32(
+				_mm_add_epi32(
+					sum_pairs(dot_4_pixels(p0_lo, p0_hi,
+							       coef_u),
+						  dot_4_pixels(p1_lo, p1_hi,
+							       coef_u)),
+					c_bias_v),
+				COEF_SHIFT + 1);
+			__m128i v = _mm_srai_epi32(
+				_mm_add_epi32(
+					sum_pairs(dot_4_pixels(p0_lo, p0_hi,
+							       coef_v),
+						  dot_4_pixels(p1_lo, p1_hi,
+							       coef_v)),
+					c_bias_v),
+				COEF_SHIFT + 1);
+			// [U0 U1 U2 U3 V0 V1 V2 V3] -> [U0 V0 U1 V1 U2 V2 U3 V3]
+			__m128i uv16 = _mm_packs_epi32(u, v);
+			uv16 = _mm_unpacklo_epi16(uv16,
+						  _mm_srli_si128(uv16, 8));
+
+			// [U0 Y0 V0 Y1 U1 Y2 V1 Y3 | U2 Y4 V2 Y5 U3 Y6 V3 Y7]
+			__m128i uyvy = _mm_packus_epi16(
+				_mm_unpacklo_epi16(uv16, y16),
+				_mm_unpackhi_epi16(uv16, y16));
+			_mm_storeu_si128((__m128i *)(out + (size_t)x * 2),
+					 uyvy);
+
+			__m128i a16 = _mm_packs_epi32(_mm_srli_epi32(p0, 24),
+						      _mm_srli_epi32(p1, 24));
+			_mm_storel_epi64((__m128i *)(out_alpha + x),
+					 _mm_packus_epi16(a16, zero));
+		}
+
+		for (; x + 1 < width; x += 2) {
+			const uint8_t *pixel0 = in + (size_t)x * 4;
+			const uint8_t *pixel1 = pixel0 + 4;
+			uint8_t *uyvy = out + (size_t)x * 2;
+			uyvy[0] = clamp_u8((dot_pixel(matrix->u, pixel0) +
+					    dot_pixel(matrix->u, pixel1) +
+					    c_bias) >>
+					   (COEF_SHIFT + 1));
+			uyvy[1] = clamp_u8(
+				(dot_pixel(matrix->y, pixel0) + y_bias) >>
+				COEF_SHIFT);
+			uyvy[2] = clamp_u8((dot_pixel(matrix->v, pixel0) +
+					    dot_pixel(matrix->v, pixel1) +
+					    c_bias) >>
+					   (COEF_SHIFT + 1));
+			uyvy[3] = clamp_u8(
+				(dot_pixel(matrix->y, pixel1) + y_bias) >>
+				COEF_SHIFT);
+			out_alpha[x] = pixel0[3];
+			out_alpha[x + 1] = pixel1[3];
+		}
+	}
+}
+
+void convert_uyvy_to_nv12(const uint8_t *input, uint32_t in_linesize,
+			  uint32_t width, uint32_t height, uint32_t start_y,
+			  uint32_t end_y, uint8_t *luma, uint32_t luma_linesize,
+			  uint8_t *chroma, uint32_t chroma_linesize)
+{
+	const __m128i chroma_mask = _mm_set1_epi16(0x00ff);
+	const uint32_t simd_width = width & ~15u;
+
+	if (end_y > height) {
+		end_y = height;
+	}
+
+	for (uint32_t row = start_y; row < end_y; row += 2) {
+		// The last row of an odd height frame is its own pair
+		const bool has_second = row + 1 < height;
+		const uint8_t *in0 = input + (size_t)row * in_linesize;
+		const uint8_t *in1 = has_second ? in0 + in_linesize : in0;
+		uint8_t *out_y0 = luma + (size_t)row * luma_linesize;
+		uint8_t *out_y1 = out_y0 + luma_linesize;
+		uint8_t *out_uv = chroma + (size_t)(row / 2) * chroma_linesize;
+
+		uint32_t x = 0;
+		for (; x < simd_width; x += 16) {
+			// [U0 Y0 V0 Y1 ...] x 16 pixels, per row
+			__m128i a0 = _mm_loadu_si128(
+				(const __m128i *)(in0 + (size_t)x * 2));
+			__m128i a1 = _mm_loadu_si128(
+				(const __m128i *)(in0 + (size_t)x * 2 + 16));
+			__m128i b0 = _mm_loadu_si128(
+				(const __m128i *)(in1 + (size_t)x * 2));
+			__m128i b1 = _mm_loadu_si128(
+				(const __m128i *)(in1 + (size_t)x * 2 + 16));
+
+			_mm_storeu_si128(
+				(__m128i *)(out_y0 + x),
+				_mm_packus_epi16(_mm_srli_epi16(a0, 8),
+						 _mm_srli_epi16(a1, 8)));
+			if (has_second) {
+				_mm_storeu_si128(
+					(__m128i *)(out_y1 + x),
+					_mm_packus_epi16(
+						_mm_srli_epi16(b0, 8),
+						_mm_srli_epi16(b1, 8)));
+			}
+
+			// Even bytes are already in NV12 order: U0 V0 U1 V1 ...
+			__m128i uv0 = _mm_packus_epi16(
+				_mm_and_si128(a0, chroma_mask),
+				_mm_and_si128(a1, chroma_mask));
+			__m128i uv1 = _mm_packus_epi16(
+				_mm_and_si128(b0, chroma_mask),
+				_mm_and_si128(b1, chroma_mask));
+			_mm_storeu_si128((__m128i *)(out_uv + x),
+					 _mm_avg_epu8(uv0, uv1));
+		}
+
+		for (; x + 1 < width; x += 2) {
+			const uint8_t *p0 = in0 + (size_t)x * 2;
+			const uint8_t *p1 = in1 + (size_t)x * 2;
+			out_y0[x] = p0[1];
+			out_y0[x + 1] = p0[3];
+			if (has_second) {
+				out_y1[x] = p1[1];
+				out_y1[x + 1] = p1[3];
+			}
+			out_uv[x] = (uint8_t)((p0[0] + p1[0] + 1) >> 1);
+			out_uv[x + 1] = (uint8_t)((p0[2] + p1[2] + 1) >> 1);
+		}
+	}
+}
+
+// Area weights are 1.14 fixed point and sum to exactly 1 per output pixel
+#define SCALE_SHIFT 14
+
+/**
+ * Coverage of output pixel `index` over the input pixels of one dimension.
+ * Output pixel `index` spans [index, index + 1) * in_size / out_size input
+ * pixels; each input pixel it touches is weighted by the overlap.
+ * Weights are packed in pairs for madd, low half first, and broadcast to
+ * every lane; an odd last pair gets a zero second weight.
+ * @return the number of pairs written, starting at input pixel `*first`
+ */
+static uint32_t scale_area_weights(uint32_t in_size, uint32_t out_size,
+				   uint32_t index, uint32_t *first,
+				   __m128i *pairs)
+{
+	// In units of 1 / out_size input pixel
+	const uint64_t begin = (uint64_t)index * in_size;
+	const uint64_t end = begin + in_size;
+	const uint32_t start = (uint32_t)(begin / out_size);
+	const uint32_t stop = (uint32_t)((end + out_size - 1) / out_size);
+
+	// Rounding the running total keeps the sum exact
+	uint64_t covered = 0;
+	uint32_t previous = 0;
+	uint32_t packed = 0;
+	for (uint32_t i = start; i < stop; ++i) {
+		uint64_t lo = (uint64_t)i * out_size;
+		uint64_t hi = lo + out_size;
+		covered += (hi < end ? hi : end) - (lo > begin ? lo : begin);
+		uint32_t next = (uint32_t)(((covered << SCALE_SHIFT) +
+					    in_size / 2) /
+					   in_size);
+		uint32_t k = i - start;
+		if (k % 2 == 0) {
+			packed = next - previous;
+		} else {
+			packed |= (next - previous) << 16;
+			_mm_storeu_si128(pairs + k / 2,
+					 _mm_set1_epi32((int32_t)packed));
+		}
+		previous = next;
+	}
+	const uint32_t count = stop - start;
+	if (count % 2) {
+		_mm_storeu_si128(pairs + count / 2,
+				 _mm_set1_epi32((int32_t)packed));
+	}
+	*first = start;
+	return (count + 1) / 2;
+}
+
+/**
+ * Area-weighted sum of the input rows under one output row, scaled to 128
+ * per unit so that two sums times a weight still fit a madd.
+ * `rows` holds `pairs` pairs of row pointers, an odd last row repeated, and
+ * `weights` their weights broadcast to every lane.
+ */
+static void scale_rgba_rows(const uint8_t *const *rows, const __m128i *weights,
+			    uint32_t pairs, uint32_t row_bytes, int16_t *out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1 << 6);
+
+	uint32_t i = 0;
+	for (; i + 16 <= row_bytes; i += 16) {
+		__m128i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+		for (uint32_t k = 0; k < pairs; ++k) {
+			__m128i a = _mm_loadu_si128(
+				(const __m128i *)(rows[k * 2] + i));
+			__m128i b = _mm_loadu_si128(
+				(const __m128i *)(rows[k * 2 + 1] + i));
+			// [a0 b0 a1 b1 ...]: the pairs madd expects
+			__m128i lo = _mm_unpacklo_epi8(a, b);
+			__m128i hi = _mm_unpackhi_epi8(a, b);
+			__m128i w = _mm_loadu_si128(weights + k);
+			s0 = _mm_add_epi32(
+				s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero),
+						   w));
+			s1 = _mm_add_epi32(
+				s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero),
+						   w));
+			s2 = _mm_add_epi32(
+				s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero),
+						   w));
+			s3 = _mm_add_epi32(
+				s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero),
+						   w));
+		}
+		s0 = _mm_srai_epi32(_mm_add_epi32(s0, round), 7);
+		s1 = _mm_srai_epi32(_mm_add_epi32(s1, round), 7);
+		s2 = _mm_srai_epi32(_mm_add_epi32(s2, round), 7);
+		s3 = _mm_srai_epi32(_mm_add_epi32(s3, round), 7);
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(s0, s1));
+		_mm_storeu_si128((__m128i *)(out + i + 8),
+				 _mm_packs_epi32(s2, s3));
+	}
+	for (; i < row_bytes; ++i) {
+		int32_t sum = 0;
+		for (uint32_t k = 0; k < pairs; ++k) {
+			int32_t w = _mm_cvtsi128_si32(
+				_mm_loadu_si128(weights + k));
+			sum += rows[k * 2][i] * (int16_t)w +
+			       rows[k * 2 + 1][i] * (w >> 16);
+		}
+		out[i] = (int16_t)((sum + (1 << 6)) >> 7);
+	}
+}
+
+/**
+ * Area-weighted sum of the summed row's pixels under one output pixel, back
+ * to 8 bits (as 32 bit lanes) apart from the final packing.
+ */
+template<uint32_t fixed_pairs>
+static inline __m128i scale_rgba_pixel(const int16_t *pixel,
+				       const __m128i *weights, uint32_t pairs)
+{
+	if (fixed_pairs) {
+		pairs = fixed_pairs;
+	}
+	__m128i sum = _mm_set1_epi32(1 << 20);
+	for (uint32_t k = 0; k < pairs; ++k) {
+		// [c0 c1 c2 c3 c0' c1' c2' c3'] to [c0 c0' c1 c1' ...]
+		__m128i v = _mm_loadu_si128((const __m128i *)(pixel + k * 8));
+		v = _mm_unpacklo_epi16(v, _mm_unpackhi_epi64(v, v));
+		sum = _mm_add_epi32(
+			sum, _mm_madd_epi16(v, _mm_loadu_si128(weights + k)));
+	}
+	return _mm_srai_epi32(sum, 21);
+}
+
+/**
+ * Scales the summed row horizontally. Every output pixel has `pairs` pairs
+ * of weights, zero padded; a compile-time count lets the common footprints
+ * unroll. `alpha` is ORed into every output pixel.
+ */
+template<uint32_t fixed_pairs>
+static void scale_rgba_columns(const int16_t *row, const uint32_t *x_first,
+			       const __m128i *weights, uint32_t pairs,
+			       __m128i alpha, uint32_t out_width, uint8_t *out)
+{
+	if (fixed_pairs) {
+		pairs = fixed_pairs;
+	}
+
+	// Four pixels at a time, packed back to 8 bits together
+	uint32_t x = 0;
+	for (; x + 4 <= out_width; x += 4) {
+		__m128i p0 = scale_rgba_pixel<fixed_pairs>(
+			row + (size_t)x_first[x] * 4, weights, pairs);
+		__m128i p1 = scale_rgba_pixel<fixed_pairs>(
+			row + (size_t)x_first[x + 1] * 4, weights + pairs,
+			pairs);
+		__m128i p2 = scale_rgba_pixel<fixed_pairs>(
+			row + (size_t)x_first[x + 2] * 4, weights + 2 * pairs,
+			pairs);
+		__m128i p3 = scale_rgba_pixel<fixed_pairs>(
+			row + (size_t)x_first[x + 3] * 4, weights + 3 * pairs,
+			pairs);
+		weights += 4 * pairs;
+		_mm_storeu_si128(
+			(__m128i *)(out + x * 4),
+			_mm_or_si128(_mm_packus_epi16(_mm_packs_epi32(p0, p1),
+						      _mm_packs_epi32(p2, p3)),
+				     alpha));
+	}
+	for (; x < out_width; ++x) {
+		__m128i p = scale_rgba_pixel<fixed_pairs>(
+			row + (size_t)x_first[x] * 4, weights, pairs);
+		weights += pairs;
+		p = _mm_packus_epi16(_mm_packs_epi32(p, p), p);
+		uint32_t value = (uint32_t)_mm_cvtsi128_si32(
+			_mm_or_si128(p, alpha));
+		memcpy(out + x * 4, &value, 4);
+	}
+}
+
+void scale_rgba(const uint8_t *input, uint32_t in_linesize, uint32_t in_width,
+		uint32_t in_height, uint8_t *output, uint32_t out_linesize,
+		uint32_t out_width, uint32_t out_height, bool opaque)
+{
+	if (!in_width || !in_height || !out_width || !out_height) {
+		return;
+	}
+
+	// An output pixel covers at most in / out + 2 input pixels
+	const uint32_t row_bytes = in_width * 4;
+	const uint32_t max_x_pairs = (in_width / out_width + 3) / 2;
+	const uint32_t max_y_pairs = (in_height / out_height + 3) / 2;
+	const size_t x_pairs_size = (size_t)out_width * max_x_pairs;
+	// Spare pixels, so that every pair of every footprint can be loaded
+	const size_t row_size = (size_t)row_bytes + max_x_pairs * 8;
+	uint8_t *scratch = (uint8_t *)bmalloc(
+		(x_pairs_size + max_y_pairs) * sizeof(__m128i) +
+		(size_t)max_y_pairs * 2 * sizeof(uint8_t *) +
+		(size_t)out_width * sizeof(uint32_t) +
+		row_size * sizeof(int16_t));
+	__m128i *x_weights = (__m128i *)scratch;
+	__m128i *y_weights = x_weights + x_pairs_size;
+	const uint8_t **y_rows = (const uint8_t **)(y_weights + max_y_pairs);
+	uint32_t *x_first = (uint32_t *)(y_rows + 2 * max_y_pairs);
+	int16_t *row = (int16_t *)(x_first + out_width);
+	memset(row + row_bytes, 0, (row_size - row_bytes) * sizeof(int16_t));
+	const __m128i alpha = opaque ? _mm_set1_epi32((int)0xFF000000)
+				     : _mm_setzero_si128();
+
+	// Horizontal footprints are the same for every row. Each one gets
+	// the widest footprint's number of pairs, the extra ones weighing 0.
+	uint32_t x_pairs = 1;
+	for (uint32_t x = 0; x < out_width; ++x) {
+		__m128i *weights = x_weights + (size_t)x * max_x_pairs;
+		uint32_t pairs = scale_area_weights(in_width, out_width, x,
+						    &x_first[x], weights);
+		for (uint32_t k = pairs; k < max_x_pairs; ++k) {
+			_mm_storeu_si128(weights + k, _mm_setzero_si128());
+		}
+		x_pairs = pairs > x_pairs ? pairs : x_pairs;
+	}
+	if (x_pairs < max_x_pairs) {
+		for (uint32_t x = 1; x < out_width; ++x) {
+			memmove(x_weights + (size_t)x * x_pairs,
+				x_weights + (size_t)x * max_x_pairs,
+				x_pairs * sizeof(__m128i));
+		}
+	}
+
+	for (uint32_t y = 0; y < out_height; ++y) {
+		uint32_t y_first;
+		uint32_t y_pairs = scale_area_weights(in_height, out_height, y,
+						      &y_first, y_weights);
+		for (uint32_t k = 0; k < y_pairs * 2; ++k) {
+			uint32_t sy = y_first + k < in_height ? y_first + k
+							      : in_height - 1;
+			y_rows[k] = input + (size_t)sy * in_linesize;
+		}
+		scale_rgba_rows(y_rows, y_weights, y_pairs, row_bytes, row);
+
+		uint8_t *out = output + (size_t)y * out_linesize;
+		switch (x_pairs) {
+		case 1:
+			scale_rgba_columns<1>(row, x_first, x_weights, 1,
+					      alpha, out_width, out);
+			break;
+		case 2:
+			scale_rgba_columns<2>(row, x_first, x_weights, 2,
+					      alpha, out_width, out);
+			break;
+		default:
+			scale_rgba_columns<0>(row, x_first, x_weights,
+					      x_pairs, alpha, out_width, out);
+			break;
+		}
+	}
+
+	bfree(scratch);
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <media-io/video-io.h>
+
+#include <stdint.h>
+
+/**
+ * RGB to YUV coefficients laid out for the SIMD converters.
+ * Each `y`/`u`/`v` row holds the 1.14 fixed point coefficients for the
+ * 4 bytes of one pixel (in memory order, alpha coefficient always 0),
+ * repeated for 2 pixels.
+ */
+typedef struct rgb_to_yuv_matrix_t {
+	int16_t y[8];
+	int16_t u[8];
+	int16_t v[8];
+	int32_t y_offset;
+	int32_t c_offset;
+} rgb_to_yuv_matrix_t;
+
+/**
+ * @param format VIDEO_FORMAT_RGBA, VIDEO_FORMAT_BGRA or VIDEO_FORMAT_BGRX
+ * @return false if `format` is not a packed 32 bit RGB format
+ */
+bool rgb_to_yuv_matrix_init(rgb_to_yuv_matrix_t *matrix, video_format format,
+			    video_colorspace colorspace,
+			    video_range_type range);
+
+/**
+ * Converts rows [start_y, end_y) of a packed RGBA/BGRA frame to NDI UYVA:
+ * a UYVY plane followed by an 8 bit alpha plane.
+ * Rows are independent, so a frame may be converted in stripes.
+ * `width` must be even.
+ */
+void convert_rgba_to_uyva(const rgb_to_yuv_matrix_t *matrix,
+			  const uint8_t *input, uint32_t in_linesize,
+			  uint32_t width, uint32_t start_y, uint32_t end_y,
+			  uint8_t *output, uint32_t out_linesize,
+			  uint8_t *alpha, uint32_t alpha_linesize);
+
+/**
+ * Repacks rows [start_y, end_y) of a UYVY frame into NV12: a full resolution
+ * Y plane and a half height plane of interleaved U/V, each U/V pair being the
+ * average of the two rows it covers.
+ * `start_y` must be even so that stripes cover whole row pairs.
+ * `width` must be even.
+ */
+void convert_uyvy_to_nv12(const uint8_t *input, uint32_t in_linesize,
+			  uint32_t width, uint32_t height, uint32_t start_y,
+			  uint32_t end_y, uint8_t *luma, uint32_t luma_linesize,
+			  uint8_t *chroma, uint32_t chroma_linesize);
+
+/**
+ * Resamples a packed 32 bit frame into an `out_width` x `out_height` rectangle
+ * with an area (box) filter: each output pixel is the average of the input
+ * pixels it covers, weighted by how much of each it covers, so the footprint
+ * always matches the scale ratio and downscaling does not alias.
+ * With `opaque` the output alpha is forced to 0xFF, for BGRX input whose
+ * fourth byte is undefined.
+ */
+void scale_rgba(const uint8_t *input, uint32_t in_linesize, uint32_t in_width,
+		uint32_t in_height, uint8_t *output, uint32_t out_linesize,
+		uint32_t out_width, uint32_t out_height, bool opaque);
@@ -0,0 +1,234 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// Checks convert_uyvy_to_nv12 and scale_rgba against scalar references, then
+// times them: the repack on 1080p and 2160p frames, with the upload bytes it
+// saves, and the scaler on the NDI Grid's typical tile sizes.
+//
+// Usage: bench-video-conv [frames]
+
+#include "video-conv.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static void reference_uyvy_to_nv12(const uint8_t *input, uint32_t in_linesize,
+				   uint32_t width, uint32_t height,
+				   uint8_t *luma, uint8_t *chroma)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			luma[y * width + x] = input[y * in_linesize + x * 2 + 1];
+		}
+	}
+	for (uint32_t y = 0; y < height; y += 2) {
+		const uint32_t next = y + 1 < height ? y + 1 : y;
+		for (uint32_t x = 0; x < width; x++) {
+			chroma[y / 2 * width + x] =
+				(uint8_t)((input[y * in_linesize + x * 2] +
+					   input[next * in_linesize + x * 2] +
+					   1) >>
+					  1);
+		}
+	}
+}
+
+static bool check(uint32_t width, uint32_t height)
+{
+	// Padded rows, converted in two stripes
+	const uint32_t in_linesize = width * 2 + 6;
+	std::vector<uint8_t> input((size_t)in_linesize * height);
+	for (auto &value : input) {
+		value = (uint8_t)rand();
+	}
+
+	const size_t luma_size = (size_t)width * height;
+	const size_t chroma_size = (size_t)width * ((height + 1) / 2);
+	std::vector<uint8_t> luma(luma_size), chroma(chroma_size);
+	std::vector<uint8_t> expected_luma(luma_size),
+		expected_chroma(chroma_size);
+	const uint32_t split = height > 2 ? 2 : height;
+	convert_uyvy_to_nv12(input.data(), in_linesize, width, height, 0,
+			     split, luma.data(), width, chroma.data(), width);
+	convert_uyvy_to_nv12(input.data(), in_linesize, width, height, split,
+			     height, luma.data(), width, chroma.data(), width);
+	reference_uyvy_to_nv12(input.data(), in_linesize, width, height,
+			       expected_luma.data(), expected_chroma.data());
+
+	if (luma != expected_luma || chroma != expected_chroma) {
+		fprintf(stderr, "%ux%u: mismatch with the reference\n", width,
+			height);
+		return false;
+	}
+	return true;
+}
+
+// Exact area average: every input pixel weighted by how much of the output
+// pixel it covers
+static void reference_scale_rgba(const uint8_t *input, uint32_t in_linesize,
+				 uint32_t in_width, uint32_t in_height,
+				 double *output, uint32_t out_width,
+				 uint32_t out_height)
+{
+	const double step_x = (double)in_width / out_width;
+	const double step_y = (double)in_height / out_height;
+	for (uint32_t y = 0; y < out_height; y++) {
+		const double y0 = y * step_y, y1 = y0 + step_y;
+		for (uint32_t x = 0; x < out_width; x++) {
+			const double x0 = x * step_x, x1 = x0 + step_x;
+			double sum[4] = {};
+			for (uint32_t sy = (uint32_t)y0; sy < y1; sy++) {
+				const double wy = fmin(sy + 1, y1) -
+						  fmax(sy, y0);
+				for (uint32_t sx = (uint32_t)x0; sx < x1;
+				     sx++) {
+					const double wx = fmin(sx + 1, x1) -
+							  fmax(sx, x0);
+					const uint8_t *pixel =
+						input + sy * in_linesize +
+						sx * 4;
+					for (int c = 0; c < 4; c++) {
+						sum[c] += pixel[c] * wx * wy;
+					}
+				}
+			}
+			for (int c = 0; c < 4; c++) {
+				output[(y * out_width + x) * 4 + c] =
+					sum[c] / (step_x * step_y);
+			}
+		}
+	}
+}
+
+static bool check_scale(uint32_t in_width, uint32_t in_height,
+			uint32_t out_width, uint32_t out_height,
+			bool opaque = false)
+{
+	const uint32_t in_linesize = in_width * 4 + 12;
+	const uint32_t out_linesize = out_width * 4 + 8;
+	std::vector<uint8_t> input((size_t)in_linesize * in_height);
+	for (auto &value : input) {
+		value = (uint8_t)rand();
+	}
+	std::vector<uint8_t> output((size_t)out_linesize * out_height);
+	std::vector<double> expected((size_t)out_width * out_height * 4);
+	scale_rgba(input.data(), in_linesize, in_width, in_height,
+		   output.data(), out_linesize, out_width, out_height, opaque);
+	reference_scale_rgba(input.data(), in_linesize, in_width, in_height,
+			     expected.data(), out_width, out_height);
+
+	// Fixed point weights and intermediate rounding: off by one at most
+	for (uint32_t y = 0; y < out_height; y++) {
+		for (uint32_t x = 0; x < out_width * 4; x++) {
+			if (opaque && x % 4 == 3) {
+				expected[y * out_width * 4 + x] = 255.0;
+			}
+			const double error =
+				fabs(output[y * out_linesize + x] -
+				     expected[y * out_width * 4 + x]);
+			if (error > 1.0) {
+				fprintf(stderr,
+					"%ux%u -> %ux%u: off by %.2f at %u,%u\n",
+					in_width, in_height, out_width,
+					out_height, error, x / 4, y);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void bench(uint32_t width, uint32_t height, int frames)
+{
+	const size_t luma_size = (size_t)width * height;
+	std::vector<uint8_t> input(luma_size * 2);
+	std::vector<uint8_t> output(luma_size * 3 / 2);
+	for (auto &value : input) {
+		value = (uint8_t)rand();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; i++) {
+		convert_uyvy_to_nv12(input.data(), width * 2, width, height, 0,
+				     height, output.data(), width,
+				     output.data() + luma_size, width);
+	}
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+
+	printf("%ux%u: %.3f ms/frame, upload %.2f MB -> %.2f MB per frame\n",
+	       width, height, elapsed.count() / frames,
+	       (double)luma_size * 2 / 1e6, (double)luma_size * 1.5 / 1e6);
+}
+
+static void bench_scale(uint32_t in_width, uint32_t in_height,
+			uint32_t out_width, uint32_t out_height, int frames)
+{
+	std::vector<uint8_t> input((size_t)in_width * in_height * 4);
+	std::vector<uint8_t> output((size_t)out_width * out_height * 4);
+	for (auto &value : input) {
+		value = (uint8_t)rand();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < frames; i++) {
+		scale_rgba(input.data(), in_width * 4, in_width, in_height,
+			   output.data(), out_width * 4, out_width, out_height,
+			   false);
+	}
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+
+	printf("scale %ux%u -> %ux%u: %.3f ms/frame\n", in_width, in_height,
+	       out_width, out_height, elapsed.count() / frames);
+}
+
+int main(int argc, char **argv)
+{
+	const int frames = argc > 1 ? atoi(argv[1]) : 200;
+
+	bool ok = true;
+	for (uint32_t width : {2u, 18u, 34u, 1920u}) {
+		for (uint32_t height : {1u, 3u, 4u, 7u, 1080u}) {
+			ok &= check(width, height);
+		}
+	}
+	ok &= check_scale(1920, 1080, 960, 540);
+	ok &= check_scale(1920, 1080, 640, 360);
+	ok &= check_scale(1280, 720, 473, 266);
+	ok &= check_scale(37, 23, 5, 3);
+	ok &= check_scale(64, 36, 160, 90);
+	ok &= check_scale(3, 2, 7, 5);
+	ok &= check_scale(1, 1, 4, 4);
+	ok &= check_scale(1280, 720, 473, 266, true);
+	ok &= check_scale(3, 2, 7, 5, true);
+	if (!ok) {
+		return EXIT_FAILURE;
+	}
+
+	bench(1920, 1080, frames);
+	bench(3840, 2160, frames);
+	// 2x2 and 4x4 grids of 1080p canvases, full and lowest bandwidth feeds
+	bench_scale(1920, 1080, 960, 540, frames);
+	bench_scale(1920, 1080, 480, 270, frames);
+	bench_scale(640, 360, 960, 540, frames);
+	bench_scale(640, 360, 480, 270, frames);
+	return EXIT_SUCCESS;
+}
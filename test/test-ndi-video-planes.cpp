@@ -0,0 +1,198 @@
+/******************************************************************************
+	Copyright (C) 2016-2024 DistroAV <contact@distroav.org>
+
+	This program is free software; you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation; either version 2
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program; if not, see <https://www.gnu.org/licenses/>.
+******************************************************************************/
+
+// Feeds synthetic planar frames from a mock NDI runtime through
+// ndi_video_planes_get and checks the plane pointers and line sizes OBS
+// would be handed.
+
+#include "ndi-video-planes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Plane markers written by the mock sender
+#define MARK_Y 0x10
+#define MARK_U 0x40
+#define MARK_V 0xc0
+#define MARK_UV 0x80
+
+typedef struct mock_receiver_t {
+	NDIlib_FourCC_video_type_e fourcc;
+	int xres;
+	int yres;
+	int stride;
+} mock_receiver_t;
+
+static size_t mock_frame_size(const mock_receiver_t *recv)
+{
+	const size_t luma = (size_t)recv->stride * recv->yres;
+	const size_t chroma_rows = (size_t)(recv->yres + 1) / 2;
+	if (recv->fourcc == NDIlib_FourCC_video_type_NV12)
+		return luma + (size_t)recv->stride * chroma_rows;
+	return luma + 2 * (size_t)(recv->stride / 2) * chroma_rows;
+}
+
+// Lays out a frame the way the NDI runtime does: one buffer holding the
+// padded Y plane followed by the chroma plane(s), each chroma row padded to
+// the chroma stride.
+static NDIlib_frame_type_e
+mock_recv_capture_v3(NDIlib_recv_instance_t p_instance,
+		     NDIlib_video_frame_v2_t *p_video_data,
+		     NDIlib_audio_frame_v3_t *, NDIlib_metadata_frame_t *,
+		     uint32_t)
+{
+	auto recv = (const mock_receiver_t *)p_instance;
+	const size_t size = mock_frame_size(recv);
+	auto buffer = (uint8_t *)malloc(size);
+	const size_t luma = (size_t)recv->stride * recv->yres;
+	memset(buffer, MARK_Y, luma);
+
+	if (recv->fourcc == NDIlib_FourCC_video_type_NV12) {
+		memset(buffer + luma, MARK_UV, size - luma);
+	} else {
+		const size_t plane = (size - luma) / 2;
+		const bool is_yv12 = recv->fourcc ==
+				     NDIlib_FourCC_video_type_YV12;
+		memset(buffer + luma, is_yv12 ? MARK_V : MARK_U, plane);
+		memset(buffer + luma + plane, is_yv12 ? MARK_U : MARK_V,
+		       plane);
+	}
+
+	*p_video_data = NDIlib_video_frame_v2_t();
+	p_video_data->xres = recv->xres;
+	p_video_data->yres = recv->yres;
+	p_video_data->FourCC = recv->fourcc;
+	p_video_data->p_data = buffer;
+	p_video_data->line_stride_in_bytes = recv->stride;
+	return NDIlib_frame_type_video;
+}
+
+static void mock_recv_free_video_v2(NDIlib_recv_instance_t,
+				    const NDIlib_video_frame_v2_t *p_video_data)
+{
+	free(p_video_data->p_data);
+}
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+	do {                                                                \
+		if (!(cond)) {                                              \
+			fprintf(stderr, "%s: %dx%d stride %d: %s failed\n", \
+				name, recv.xres, recv.yres, recv.stride,    \
+				#cond);                                     \
+			failures++;                                         \
+		}                                                           \
+	} while (0)
+
+// Every row of the plane, up to its visible width, must carry `mark` and
+// stay inside the frame buffer.
+static bool plane_is(const NDIlib_video_frame_v2_t *frame, size_t size,
+		     const uint8_t *plane, uint32_t linesize, uint32_t width,
+		     uint32_t rows, uint8_t mark)
+{
+	for (uint32_t y = 0; y < rows; y++) {
+		const uint8_t *row = plane + (size_t)linesize * y;
+		if (row < frame->p_data || row + width > frame->p_data + size)
+			return false;
+		for (uint32_t x = 0; x < width; x++) {
+			if (row[x] != mark)
+				return false;
+		}
+	}
+	return true;
+}
+
+static void test_frame(const NDIlib_v5 *lib, const char *name,
+		       enum ndi_video_planes planes,
+		       NDIlib_FourCC_video_type_e fourcc, int xres, int yres,
+		       int stride)
+{
+	mock_receiver_t recv = {fourcc, xres, yres, stride};
+	NDIlib_video_frame_v2_t frame;
+	lib->recv_capture_v3((NDIlib_recv_instance_t)&recv, &frame, nullptr,
+			     nullptr, 0);
+
+	uint8_t *data[3];
+	uint32_t linesize[3];
+	ndi_video_planes_get(planes, &frame, data, linesize);
+
+	const size_t size = mock_frame_size(&recv);
+	const uint32_t width = (uint32_t)xres;
+	const uint32_t height = (uint32_t)yres;
+	const uint32_t chroma_width = (width + 1) / 2;
+	const uint32_t chroma_rows = (height + 1) / 2;
+
+	CHECK(data[0] == frame.p_data);
+	CHECK(linesize[0] == (uint32_t)stride);
+	CHECK(plane_is(&frame, size, data[0], linesize[0], width, height,
+		       MARK_Y));
+
+	if (planes == NDI_VIDEO_PLANES_NV12) {
+		CHECK(data[1] == frame.p_data + (size_t)stride * yres);
+		CHECK(linesize[1] == (uint32_t)stride);
+		CHECK(plane_is(&frame, size, data[1], linesize[1],
+			       chroma_width * 2, chroma_rows, MARK_UV));
+		CHECK(data[2] == nullptr);
+		CHECK(linesize[2] == 0);
+	} else {
+		CHECK(linesize[1] == (uint32_t)stride / 2);
+		CHECK(linesize[2] == (uint32_t)stride / 2);
+		CHECK(plane_is(&frame, size, data[1], linesize[1],
+			       chroma_width, chroma_rows, MARK_U));
+		CHECK(plane_is(&frame, size, data[2], linesize[2],
+			       chroma_width, chroma_rows, MARK_V));
+	}
+
+	lib->recv_free_video_v2((NDIlib_recv_instance_t)&recv, &frame);
+}
+
+int main(void)
+{
+	NDIlib_v5 lib = {};
+	lib.recv_capture_v3 = mock_recv_capture_v3;
+	lib.recv_free_video_v2 = mock_recv_free_video_v2;
+
+	static const struct {
+		int xres;
+		int yres;
+		int stride;
+	} sizes[] = {
+		{1920, 1080, 1920}, // Tightly packed
+		{1920, 1080, 2048}, // Padded rows
+		{1280, 721, 1280},  // Odd height
+		{1280, 721, 1344},  // Odd height, padded rows
+		{638, 359, 704},    // Small, odd height, padded rows
+	};
+
+	for (const auto &s : sizes) {
+		test_frame(&lib, "I420", NDI_VIDEO_PLANES_I420,
+			   NDIlib_FourCC_video_type_I420, s.xres, s.yres,
+			   s.stride);
+		test_frame(&lib, "YV12", NDI_VIDEO_PLANES_YV12,
+			   NDIlib_FourCC_video_type_YV12, s.xres, s.yres,
+			   s.stride);
+		test_frame(&lib, "NV12", NDI_VIDEO_PLANES_NV12,
+			   NDIlib_FourCC_video_type_NV12, s.xres, s.yres,
+			   s.stride);
+	}
+
+	if (failures)
+		fprintf(stderr, "%d check(s) failed\n", failures);
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}